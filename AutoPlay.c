@@ -0,0 +1,125 @@
+// AutoPlay.c
+// Runs on LM4F120/TM4C123
+// Autoplay bot, see AutoPlay.h
+
+#include <stdint.h>
+#include "AutoPlay.h"
+#include "Calibration.h"
+#include "Replay.h"
+
+// where the bot is in the game over screens
+enum Phase {
+    PLAYING,  // steering
+    OVER,     // game over, about to press a button
+    ENTRY,    // on the high score entry screen, SW1 again saves
+    SAVED,    // high score saved, SW2 restarts
+    RESTART   // SW2 pressed, waiting for the new game
+};
+
+static void (*Look)(struct AutoPlayView *view);
+static void (*ButtonTask[2])(void);
+static int Enabled;
+static enum Phase Phase;
+static uint32_t Ticks;  // samples since the phase started
+static int16_t TargetX, TargetY;
+static uint8_t HasTarget;
+unsigned long AutoPlay_Games;
+
+void AutoPlay_Init(void (*look)(struct AutoPlayView *view), void (*button1)(void),
+                   void (*button2)(void)) {
+    Look = look;
+    ButtonTask[0] = button1;
+    ButtonTask[1] = button2;
+    Enabled = 0;
+}
+
+void AutoPlay_Enable(int on) {
+    Phase = PLAYING;
+    Ticks = 0;
+    HasTarget = 0;
+    AutoPlay_Games = 0;
+    Enabled = on;
+}
+
+int AutoPlay_Enabled(void) {
+    return Enabled;
+}
+
+static void Press(int button) {
+    if (Replay_Button(button)) {
+        ButtonTask[button - 1]();
+    }
+    Ticks = 0;
+}
+
+// ADC value that deflects one axis in proportion to the error,
+// full deflection at AUTOPLAY_FULL pixels, inside the calibrated range
+static uint16_t Deflect(int axis, int32_t error) {
+    struct CalAxis *cal = &Cal_Axes[axis];
+    if (error > AUTOPLAY_FULL) error = AUTOPLAY_FULL;
+    if (error < -AUTOPLAY_FULL) error = -AUTOPLAY_FULL;
+    if (error > 0) {
+        return cal->center + (cal->max - cal->center) * error / AUTOPLAY_FULL;
+    }
+    return cal->center + (cal->center - cal->min) * error / AUTOPLAY_FULL;
+}
+
+void AutoPlay_Sample(uint16_t *x, uint16_t *y, uint8_t *select) {
+    struct AutoPlayView view;
+    if (!Enabled) return;
+    Look(&view);
+    Ticks++;
+    *x = Cal_Axes[0].center;  // stick at rest unless steering
+    *y = Cal_Axes[1].center;
+    *select = 1;  // not pressed
+    switch (Phase) {
+        case PLAYING:
+            if (view.over) {
+                Phase = OVER;
+                Ticks = 0;
+                HasTarget = 0;
+                return;
+            }
+            if (Ticks >= AUTOPLAY_REACTION) {  // look again, then chase what was seen
+                Ticks = 0;
+                HasTarget = view.target;
+                TargetX = view.targetX;
+                TargetY = view.targetY;
+            }
+            if (HasTarget) {
+                *x = Deflect(0, TargetX - view.x);
+                *y = Deflect(1, view.y - TargetY);  // screen Y grows downward
+            }
+            break;
+        case OVER:
+            if (Ticks < AUTOPLAY_PAUSE) break;
+            if ((AutoPlay_Games + 1) % AUTOPLAY_SAVEEVERY == 0) {
+                Press(1);  // enter a high score, the letters stay AAA
+                Phase = ENTRY;
+            } else {
+                Press(2);
+                Phase = RESTART;
+            }
+            break;
+        case ENTRY:
+            if (Ticks < AUTOPLAY_ENTRY) break;
+            Press(1);
+            Phase = SAVED;
+            break;
+        case SAVED:
+            if (Ticks < AUTOPLAY_PAUSE) break;
+            Press(2);
+            Phase = RESTART;
+            break;
+        case RESTART:
+            if (!view.over) {
+                AutoPlay_Games++;
+                Phase = PLAYING;
+                Ticks = 0;
+            } else if (Ticks >= AUTOPLAY_RETRY) {
+                Phase = OVER;  // the press was refused, go through the screens again
+                Ticks = 0;
+            }
+            break;
+    }
+}
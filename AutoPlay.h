@@ -0,0 +1,63 @@
+// AutoPlay.h
+// Runs on LM4F120/TM4C123
+// Autoplay bot for unattended soak tests and frame time benchmarks.
+// While it is on, AutoPlay_Sample replaces every joystick sample with
+// a deflection that steers the crosshair toward the nearest cube, and
+// after a game over the bot presses the buttons itself, so the game
+// keeps restarting for as long as the board runs.
+// It reacts like a slow player: it picks a target only every
+// AUTOPLAY_REACTION samples and then chases where that cube was, and
+// it waits AUTOPLAY_PAUSE samples before each button press.
+// Its presses go through Replay_Button, so a recorded session that
+// the bot played replays like any other.
+
+#ifndef __AUTOPLAY_H__
+#define __AUTOPLAY_H__
+
+#include <stdint.h>
+
+#define AUTOPLAY_REACTION 5    // samples between target choices, 250 ms at 20 Hz
+#define AUTOPLAY_FULL 24       // pixels off target that get full deflection
+#define AUTOPLAY_PAUSE 20      // samples before each game over button press
+#define AUTOPLAY_ENTRY 40      // samples spent on the high score entry screen
+#define AUTOPLAY_RETRY 100     // samples to wait for a restart before pressing again
+#define AUTOPLAY_SAVEEVERY 10  // save a high score every 10th game, bounds EEPROM writes
+
+// what the bot needs to know about the game, filled in by the game
+struct AutoPlayView {
+    int16_t x, y;              // crosshair position in pixels
+    int16_t targetX, targetY;  // center of the nearest cube in pixels
+    uint8_t target;            // 1 if there is a cube to chase
+    uint8_t over;              // 1 while the game over screens are up
+};
+
+// games the bot has restarted since it was turned on
+extern unsigned long AutoPlay_Games;
+
+// ******** AutoPlay_Init ************
+// connect the bot to the game, it starts off
+// input:  function that fills in the view, called from the Producer so it should not block
+//         actions of button 1 and button 2, without debouncing
+// output: none
+void AutoPlay_Init(void (*look)(struct AutoPlayView *view), void (*button1)(void),
+                   void (*button2)(void));
+
+// ******** AutoPlay_Enable ************
+// input:  1 to let the bot play, 0 to give the joystick back
+// output: none
+void AutoPlay_Enable(int on);
+
+// ******** AutoPlay_Enabled ************
+// input:  none
+// output: 1 while the bot is playing
+int AutoPlay_Enabled(void);
+
+// ******** AutoPlay_Sample ************
+// replace a joystick sample with the bot's, and press the buttons
+// after a game over, called from the Producer before Replay_Sample
+// does nothing while the bot is off
+// input:  pointers to the sample
+// output: none
+void AutoPlay_Sample(uint16_t *x, uint16_t *y, uint8_t *select);
+
+#endif
@@ -0,0 +1,81 @@
+// Buttons.c
+// Runs on LM4F120/TM4C123
+// Debounced push buttons delivered as events, see Buttons.h
+
+#include <stdint.h>
+#include "os.h"
+#include "Buttons.h"
+
+struct Button {
+    int (*Pressed)(void);
+    uint8_t Integrator;  // 0 to BUTTONS_INTEGRATE
+    uint8_t Down;        // debounced state
+    uint16_t Held;       // samples since the press, stops at the long press
+};
+
+static struct Button Buttons[BUTTONS_MAX];
+static int NumButtons;
+static struct ButtonEvent Queue[BUTTONS_QUEUESIZE];
+static uint32_t volatile PutI;  // written by the sampler only
+static uint32_t volatile GetI;  // written by Buttons_Get only
+static Sema4Type Events;        // events in the queue
+unsigned long Buttons_Dropped;
+
+int Buttons_Add(int (*pressed)(void)) {
+    if (NumButtons == BUTTONS_MAX) return -1;
+    Buttons[NumButtons].Pressed = pressed;
+    Buttons[NumButtons].Integrator = 0;
+    Buttons[NumButtons].Down = 0;
+    return NumButtons++;
+}
+
+static void Put(int button, uint8_t type) {
+    struct ButtonEvent *pt;
+    if (PutI - GetI == BUTTONS_QUEUESIZE) {
+        Buttons_Dropped++;
+        return;
+    }
+    pt = &Queue[PutI & (BUTTONS_QUEUESIZE - 1)];
+    pt->Button = button;
+    pt->Type = type;
+    pt->Time = OS_MsTime();
+    PutI++;
+    OS_Signal(&Events);
+}
+
+// periodic task, one integrator step per button
+static void Sample(void) {
+    struct Button *b;
+    int i;
+    for (i = 0; i < NumButtons; i++) {
+        b = &Buttons[i];
+        if (b->Pressed()) {
+            if (b->Integrator < BUTTONS_INTEGRATE) b->Integrator++;
+        } else if (b->Integrator > 0) {
+            b->Integrator--;
+        }
+        if (!b->Down && b->Integrator == BUTTONS_INTEGRATE) {
+            b->Down = 1;
+            b->Held = 0;
+            Put(i, BUTTON_PRESS);
+        } else if (b->Down && b->Integrator == 0) {
+            b->Down = 0;
+            Put(i, BUTTON_RELEASE);
+        } else if (b->Down && b->Held < BUTTONS_LONGPRESS / BUTTONS_PERIOD) {
+            if (++b->Held == BUTTONS_LONGPRESS / BUTTONS_PERIOD) {
+                Put(i, BUTTON_LONGPRESS);
+            }
+        }
+    }
+}
+
+int Buttons_Init(unsigned long priority) {
+    OS_InitSemaphore(&Events, 0);
+    return OS_AddPeriodicThread(&Sample, BUTTONS_PERIOD * TIME_1MS, priority);
+}
+
+void Buttons_Get(struct ButtonEvent *event) {
+    OS_Wait(&Events);
+    *event = Queue[GetI & (BUTTONS_QUEUESIZE - 1)];
+    GetI++;
+}
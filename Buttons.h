@@ -0,0 +1,57 @@
+// Buttons.h
+// Runs on LM4F120/TM4C123
+// Debounced push buttons delivered as events.
+// One periodic task samples every button each BUTTONS_PERIOD ms and runs
+// an integrator per button: a pressed sample counts up, a released one
+// counts down, and the debounced state only changes when the integrator
+// reaches BUTTONS_INTEGRATE or 0, so a bounce has to last that many
+// samples before it is seen.  Each change is queued as a press or
+// release, and a button still held BUTTONS_LONGPRESS ms after its press
+// also queues a long press.  A foreground thread takes the events with
+// Buttons_Get; no thread is created per press and nothing touches the
+// OS ms clock.
+
+#ifndef __BUTTONS_H__
+#define __BUTTONS_H__
+
+#include <stdint.h>
+
+#define BUTTONS_MAX 4           // buttons the service can sample
+#define BUTTONS_PERIOD 5        // ms between samples
+#define BUTTONS_INTEGRATE 4     // samples that have to agree, 20 ms
+#define BUTTONS_LONGPRESS 1000  // ms held after a press that make a long press
+#define BUTTONS_QUEUESIZE 16    // events waiting for Buttons_Get, a power of 2
+
+// event types
+#define BUTTON_PRESS 1
+#define BUTTON_RELEASE 2
+#define BUTTON_LONGPRESS 3  // still held BUTTONS_LONGPRESS ms after the press
+
+struct ButtonEvent {
+    uint8_t Button;      // index Buttons_Add returned
+    uint8_t Type;        // BUTTON_ event type
+    unsigned long Time;  // OS_MsTime when the change was debounced
+};
+
+// events lost because the queue was full
+extern unsigned long Buttons_Dropped;
+
+// ******** Buttons_Add ************
+// add a button to sample, call before Buttons_Init
+// input:  function that returns nonzero while the button is held, called from the sampler
+// output: button index for the events, -1 if BUTTONS_MAX are taken
+int Buttons_Add(int (*pressed)(void));
+
+// ******** Buttons_Init ************
+// start sampling the buttons added so far
+// input:  priority of the periodic sampler, 0 is the highest
+// output: 1 if successful, 0 if the OS has no periodic slot left
+int Buttons_Init(unsigned long priority);
+
+// ******** Buttons_Get ************
+// wait for the next button event, from one foreground thread only
+// input:  pointer to store the event
+// output: none
+void Buttons_Get(struct ButtonEvent *event);
+
+#endif
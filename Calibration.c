@@ -0,0 +1,106 @@
+// Calibration.c
+// Runs on LM4F120/TM4C123
+// Joystick calibration with online center and range tracking, see Calibration.h
+
+#include <stdint.h>
+#include "Calibration.h"
+#ifdef CAL_USE_EEPROM
+#include "driverlib/eeprom.h"
+#endif
+
+long StartCritical(void);   // previous I bit, disable interrupts
+void EndCritical(long sr);  // restore I bit to previous value
+
+#define ADCMAX 4095
+
+struct CalAxis Cal_Axes[2];
+static int32_t CenterQ[2];  // running average of the rest position, Q(CAL_RESTSHIFT)
+static int Dirty;           // changed since the last save
+
+// start with 3/4 of the distance to either end of the ADC range,
+// the stick's real reach grows it from there
+void static AxisReset(int axis, int32_t rest) {
+    struct CalAxis *pt = &Cal_Axes[axis];
+    pt->center = rest;
+    pt->min = rest - (rest * 3) / 4;
+    pt->max = rest + ((ADCMAX - rest) * 3) / 4;
+    if (pt->min > rest - CAL_MINRANGE) pt->min = rest - CAL_MINRANGE;
+    if (pt->max < rest + CAL_MINRANGE) pt->max = rest + CAL_MINRANGE;
+    CenterQ[axis] = rest << CAL_RESTSHIFT;
+}
+
+void Cal_Reset(uint16_t restX, uint16_t restY) {
+    long sr;
+    sr = StartCritical();  // the Producer may be tracking
+    AxisReset(0, restX);
+    AxisReset(1, restY);
+    Dirty = 1;
+    EndCritical(sr);
+}
+
+int Cal_Init(uint16_t restX, uint16_t restY) {
+#ifdef CAL_USE_EEPROM
+    uint32_t arr[4];
+    EEPROMRead(arr, CAL_EEPROM_ADDR, sizeof(arr));
+    if (arr[0] == CAL_MAGIC) {
+        // center and min, max and center, min and max, 16 bits each
+        Cal_Axes[0].center = arr[1] & 0xFFFF;
+        Cal_Axes[0].min = arr[1] >> 16;
+        Cal_Axes[0].max = arr[2] & 0xFFFF;
+        Cal_Axes[1].center = arr[2] >> 16;
+        Cal_Axes[1].min = arr[3] & 0xFFFF;
+        Cal_Axes[1].max = arr[3] >> 16;
+        CenterQ[0] = Cal_Axes[0].center << CAL_RESTSHIFT;
+        CenterQ[1] = Cal_Axes[1].center << CAL_RESTSHIFT;
+        Dirty = 0;
+        return 1;
+    }
+#endif
+    Cal_Reset(restX, restY);
+    return 0;
+}
+
+int Cal_Track(int axis, int32_t value, int32_t deadZone) {
+    struct CalAxis *pt = &Cal_Axes[axis];
+    int32_t center;
+    int changed = 0;
+    if ((value > pt->center - deadZone) && (value < pt->center + deadZone)) {
+        CenterQ[axis] += value - (CenterQ[axis] >> CAL_RESTSHIFT);  // at rest
+        center = CenterQ[axis] >> CAL_RESTSHIFT;
+        if ((center != pt->center) && (center - CAL_MINRANGE >= pt->min) &&
+            (center + CAL_MINRANGE <= pt->max)) {
+            pt->center = center;
+            changed = 1;
+        }
+    } else if (value < pt->min) {
+        pt->min = value;
+        changed = 1;
+    } else if (value > pt->max) {
+        pt->max = value;
+        changed = 1;
+    }
+    Dirty |= changed;
+    return changed;
+}
+
+int Cal_Save(void) {
+#ifdef CAL_USE_EEPROM
+    uint32_t arr[4];
+    long sr;
+    sr = StartCritical();  // take a consistent copy
+    if (!Dirty) {
+        EndCritical(sr);
+        return 0;
+    }
+    arr[0] = CAL_MAGIC;
+    arr[1] = Cal_Axes[0].center | (Cal_Axes[0].min << 16);
+    arr[2] = Cal_Axes[0].max | (Cal_Axes[1].center << 16);
+    arr[3] = Cal_Axes[1].min | (Cal_Axes[1].max << 16);
+    Dirty = 0;
+    EndCritical(sr);
+    EEPROMProgram(arr, CAL_EEPROM_ADDR, sizeof(arr));
+    return 1;
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,58 @@
+// Calibration.h
+// Runs on LM4F120/TM4C123
+// Joystick calibration that keeps itself up to date.
+// Each axis has a rest center and the smallest and largest positions
+// seen so far.  Input_Delta feeds every filtered sample to Cal_Track:
+// while the stick rests inside the dead zone the center follows it
+// with a slow running average, and any sample past the known range
+// extends it.  The result is saved in EEPROM after the leaderboard,
+// so a reboot starts from the last calibration instead of settling
+// again from a single boot-time reading.
+
+#ifndef __CALIBRATION_H__
+#define __CALIBRATION_H__
+
+#include <stdint.h>
+
+#define CAL_USE_EEPROM         // needs EEPROMInit, comment out to keep calibration in RAM only
+#define CAL_EEPROM_ADDR 0x40   // byte address, the leaderboard uses 0x00-0x23
+#define CAL_MAGIC 0xCA1B0001
+#define CAL_RESTSHIFT 5        // center time constant, 2^5 samples at rest
+#define CAL_MINRANGE 256       // smallest range kept on each side of the center
+
+struct CalAxis {
+    int32_t center;  // rest position in ADC counts
+    int32_t min;     // smallest position seen
+    int32_t max;     // largest position seen
+};
+
+// X is Cal_Axes[0], Y is Cal_Axes[1]
+extern struct CalAxis Cal_Axes[2];
+
+// ******** Cal_Init ************
+// load the saved calibration, or start a new one around the rest reading
+// call after EEPROMInit
+// input:  ADC values of X and Y at rest
+// output: 1 if the saved calibration was loaded, 0 if starting over
+int Cal_Init(uint16_t restX, uint16_t restY);
+
+// ******** Cal_Reset ************
+// forget the range and start again around the rest reading
+// input:  ADC values of X and Y at rest
+// output: none
+void Cal_Reset(uint16_t restX, uint16_t restY);
+
+// ******** Cal_Track ************
+// update one axis with a filtered sample, called from Input_Delta
+// input:  axis (0 for X, 1 for Y), filtered sample, dead zone in ADC counts
+// output: 1 if the center or range changed, 0 otherwise
+int Cal_Track(int axis, int32_t value, int32_t deadZone);
+
+// ******** Cal_Save ************
+// write the calibration to EEPROM if it changed since the last save
+// blocks for the EEPROM write, call from a foreground thread
+// input:  none
+// output: 1 if written, 0 if there was nothing to save
+int Cal_Save(void);
+
+#endif
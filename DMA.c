@@ -0,0 +1,39 @@
+// DMA.c
+// Runs on LM4F120/TM4C123
+// Shared uDMA channel control table and helpers, see DMA.h
+
+#include <stdint.h>
+#include "tm4c123gh6pm.h"
+#include "DMA.h"
+
+// 32 primary structures followed by 32 alternate structures,
+// 4 words each: source end, destination end, control, unused
+// the uDMA requires the table to be 1024 byte aligned
+static uint32_t ControlTable[256] __attribute__((aligned(1024)));
+static int Initialized = 0;
+
+void DMA_Init(void) {
+    if (Initialized) return;
+    SYSCTL_RCGCDMA_R |= 0x01;  // activate uDMA
+    while ((SYSCTL_PRDMA_R & 0x01) == 0) {
+    };                                      // allow time for clock to stabilize
+    UDMA_CFG_R = 0x01;                      // master enable
+    UDMA_CTLBASE_R = (uint32_t)ControlTable;
+    Initialized = 1;
+}
+
+void DMA_SetTransfer(uint32_t channel, uint32_t alt, volatile void *srcEnd, volatile void *dstEnd,
+                     uint32_t control) {
+    uint32_t *pt = &ControlTable[(channel + 32 * alt) * 4];
+    pt[0] = (uint32_t)srcEnd;
+    pt[1] = (uint32_t)dstEnd;
+    pt[2] = control;
+}
+
+uint32_t DMA_Remaining(uint32_t channel, uint32_t alt) {
+    uint32_t control = ControlTable[(channel + 32 * alt) * 4 + 2];
+    if ((control & DMA_MODE_M) == DMA_MODE_STOP) {
+        return 0;
+    }
+    return ((control & DMA_XFERSIZE_M) >> 4) + 1;
+}
@@ -0,0 +1,70 @@
+// DMA.h
+// Runs on LM4F120/TM4C123
+// Shared uDMA channel control table and helpers.
+// Each driver that uses the uDMA owns its channel and fills in the
+// primary and, for ping-pong transfers, the alternate control structure.
+// Channel numbers and encodings are in the data sheet, table 9-1.
+
+#ifndef __DMA_H__
+#define __DMA_H__
+
+#include <stdint.h>
+
+// channel assignments (encoding 0 unless noted)
+#define DMA_CH_UART0RX 8
+#define DMA_CH_UART0TX 9
+#define DMA_CH_ADC0SS0 14
+#define DMA_CH_ADC0SS1 15
+#define DMA_CH_ADC0SS2 16
+#define DMA_CH_ADC0SS3 17
+#define DMA_CH_ADC1SS0 24  // encoding 1
+
+// control word fields
+#define DMA_DSTINC_8 0x00000000
+#define DMA_DSTINC_16 0x40000000
+#define DMA_DSTINC_32 0x80000000
+#define DMA_DSTINC_NONE 0xC0000000
+#define DMA_DSTSIZE_8 0x00000000
+#define DMA_DSTSIZE_16 0x10000000
+#define DMA_DSTSIZE_32 0x20000000
+#define DMA_SRCINC_8 0x00000000
+#define DMA_SRCINC_16 0x04000000
+#define DMA_SRCINC_32 0x08000000
+#define DMA_SRCINC_NONE 0x0C000000
+#define DMA_SRCSIZE_8 0x00000000
+#define DMA_SRCSIZE_16 0x01000000
+#define DMA_SRCSIZE_32 0x02000000
+#define DMA_ARB_1 0x00000000
+#define DMA_ARB_2 0x00004000
+#define DMA_ARB_4 0x00008000
+#define DMA_ARB_8 0x0000C000
+#define DMA_XFERSIZE(n) ((((uint32_t)(n)) - 1) << 4)  // 1 to 1024 items
+#define DMA_XFERSIZE_M 0x00003FF0
+#define DMA_MODE_STOP 0x00000000
+#define DMA_MODE_BASIC 0x00000001
+#define DMA_MODE_PINGPONG 0x00000003
+#define DMA_MODE_M 0x00000007
+
+// ******** DMA_Init ************
+// enable the uDMA controller and install the control table
+// safe to call from every driver that uses a channel
+// input:  none
+// output: none
+void DMA_Init(void);
+
+// ******** DMA_SetTransfer ************
+// fill in one control structure, does not enable the channel
+// input:  channel number, 0 for the primary or 1 for the alternate structure
+//         address of the last source item, address of the last destination item
+//         control word built from the DMA_ fields above
+// output: none
+void DMA_SetTransfer(uint32_t channel, uint32_t alt, volatile void *srcEnd, volatile void *dstEnd,
+                     uint32_t control);
+
+// ******** DMA_Remaining ************
+// number of items the control structure still has to move
+// input:  channel number, 0 for the primary or 1 for the alternate structure
+// output: 0 once the structure has completed
+uint32_t DMA_Remaining(uint32_t channel, uint32_t alt);
+
+#endif
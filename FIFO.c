@@ -70,9 +70,9 @@ int JsFifo_Get(jsDataType *datapt) {
 // number of elements in pointer FIFO
 // 0 to RXFIFOSIZE-1
 uint32_t JsFifo_Size(void) {
+    // pointer differences are already in elements
     if (JsPutPt < JsGetPt) {
-        return ((uint32_t)(JsPutPt - JsGetPt + (JSFIFOSIZE * sizeof(jsDataType))) /
-                sizeof(jsDataType));
+        return ((uint32_t)(JsPutPt - JsGetPt + JSFIFOSIZE));
     }
-    return ((uint32_t)(JsPutPt - JsGetPt) / sizeof(jsDataType));
+    return ((uint32_t)(JsPutPt - JsGetPt));
 }
@@ -39,6 +39,7 @@ void EndCritical(long sr);  // restore I bit to previous value
 
 typedef struct {
     uint16_t x, y;
+    uint8_t select;  // 0 if pressed
 } jsDataType;
 
 // initialize pointer FIFO
@@ -0,0 +1,52 @@
+// GameState.c
+// Runs on LM4F120/TM4C123
+// Seqlock protected game state, see GameState.h
+
+#include <stdint.h>
+#include "GameState.h"
+
+long StartCritical(void);   // previous I bit, disable interrupts
+void EndCritical(long sr);  // restore I bit to previous value
+
+struct GameState volatile Game;
+static uint32_t volatile Sequence;  // odd while a writer is changing Game
+unsigned long GameState_Retries;
+
+void GameState_Init(uint32_t life, int32_t crosshairSize) {
+    long sr;
+    sr = GameState_BeginWrite();
+    Game.Score = 0;
+    Game.Life = life;
+    Game.CrosshairSize = crosshairSize;
+    Game.Speed = 0;
+    Game.Frozen = 0;
+    GameState_EndWrite(sr);
+}
+
+long GameState_BeginWrite(void) {
+    long sr;
+    sr = StartCritical();
+    Sequence++;
+    return sr;
+}
+
+void GameState_EndWrite(long sr) {
+    Sequence++;
+    EndCritical(sr);
+}
+
+void GameState_Read(struct GameState *copy) {
+    uint32_t seq;
+    while (1) {
+        seq = Sequence;
+        if ((seq & 1) == 0) {
+            copy->Score = Game.Score;
+            copy->Life = Game.Life;
+            copy->CrosshairSize = Game.CrosshairSize;
+            copy->Speed = Game.Speed;
+            copy->Frozen = Game.Frozen;
+            if (Sequence == seq) return;
+        }
+        GameState_Retries++;
+    }
+}
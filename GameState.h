@@ -0,0 +1,55 @@
+// GameState.h
+// Runs on LM4F120/TM4C123
+// Score, lives and power-up state of the running game behind a seqlock.
+// Writers are rare (a hit, a lost life, a power-up starting or ending):
+// they bump Sequence to odd, change the fields, and bump it back to even,
+// all with interrupts disabled so two writers never interleave.
+// Readers never block or take a semaphore: they copy the fields and
+// retry if Sequence was odd or changed while they were copying, which
+// only happens when a writer preempted them.  Because a writer cannot
+// itself be interrupted, GameState_Read is safe from ISRs as well.
+
+#ifndef __GAMESTATE_H__
+#define __GAMESTATE_H__
+
+#include <stdint.h>
+
+struct GameState {
+    uint32_t Score;
+    uint32_t Life;
+    int32_t CrosshairSize;  // crosshair half width in pixels
+    int32_t Speed;          // -1 slowed down, 0 normal, 1 sped up
+    int32_t Frozen;         // 1 while the cubes do not move
+};
+
+// the live copy, change it only between GameState_BeginWrite and GameState_EndWrite
+extern struct GameState volatile Game;
+
+// number of times a reader had to copy the state again
+extern unsigned long GameState_Retries;
+
+// ******** GameState_Init ************
+// start a new game, no score and no power-ups
+// input:  lives, crosshair half width
+// output: none
+void GameState_Init(uint32_t life, int32_t crosshairSize);
+
+// ******** GameState_BeginWrite ************
+// start changing Game, disables interrupts
+// input:  none
+// output: value to pass to GameState_EndWrite
+long GameState_BeginWrite(void);
+
+// ******** GameState_EndWrite ************
+// publish the changes to Game, restores interrupts
+// input:  value returned by GameState_BeginWrite
+// output: none
+void GameState_EndWrite(long sr);
+
+// ******** GameState_Read ************
+// consistent copy of Game, never blocks
+// input:  where to copy it
+// output: none
+void GameState_Read(struct GameState *copy);
+
+#endif
@@ -0,0 +1,55 @@
+// Grid.c
+// Runs on LM4F120/TM4C123
+// Bitboard occupancy of the cube playfield, see Grid.h
+
+#include <stdint.h>
+#include "Grid.h"
+
+static uint64_t Occupied;  // bit y*8+x set when the cell is taken
+
+void Grid_Clear(void) { Occupied = 0; }
+
+int Grid_Occupied(uint32_t x, uint32_t y) { return (Occupied & GRID_BIT(x, y)) != 0; }
+
+int Grid_Take(uint32_t x, uint32_t y) {
+    uint64_t cell = GRID_BIT(x, y);
+    if (Occupied & cell) {
+        return 0;
+    }
+    Occupied |= cell;
+    return 1;
+}
+
+void Grid_Release(uint32_t x, uint32_t y) { Occupied &= ~GRID_BIT(x, y); }
+
+uint32_t Grid_FreeDirections(uint32_t x, uint32_t y) {
+    uint64_t cell = GRID_BIT(x, y);
+    uint64_t freeCells = ~Occupied & GRID_CELLS;
+    // shift the free map so each neighbour lands on the cell's own bit;
+    // the column masks stop left and right from wrapping into another row
+    // and the conditionals compile to selects, the directions are random
+    return (((freeCells << 8) & cell) ? GRID_UP : 0) |
+           (((freeCells >> 8) & cell) ? GRID_DOWN : 0) |
+           (((freeCells << 1) & cell & ~GRID_COL0) ? GRID_LEFT : 0) |
+           (((freeCells >> 1) & cell & ~GRID_COLLAST) ? GRID_RIGHT : 0);
+}
+
+int Grid_Move(uint32_t x, uint32_t y, uint32_t dir) {
+    uint64_t cell = GRID_BIT(x, y);
+    uint64_t target;
+    if ((dir == 0) || (dir & (dir - 1)) || (dir > GRID_RIGHT)) {
+        return 0;  // not one direction
+    }
+    // every neighbour masked by whether it is the one asked for, no
+    // branch on the direction; left of column 0 and right of the last
+    // column are 0
+    target = ((cell >> 8) & -(uint64_t)(dir == GRID_UP)) |
+             ((cell << 8) & -(uint64_t)(dir == GRID_DOWN)) |
+             (((cell & ~GRID_COL0) >> 1) & -(uint64_t)(dir == GRID_LEFT)) |
+             (((cell & ~GRID_COLLAST) << 1) & -(uint64_t)(dir == GRID_RIGHT));
+    if ((target & GRID_CELLS & ~Occupied) == 0) {
+        return 0;  // outside the grid or taken
+    }
+    Occupied = (Occupied & ~cell) | target;
+    return 1;
+}
@@ -0,0 +1,70 @@
+// Grid.h
+// Runs on LM4F120/TM4C123
+// Occupancy of the cube playfield as one 64-bit bitboard.
+// Cell (x, y) is bit y*8 + x, so every row starts on a byte boundary
+// whatever the width is, and a neighbour is one shift away: left and
+// right are 1 bit, up and down are 8 bits.  The playfield can be any
+// size up to 8 x 8, fixed at compile time.
+// The grid takes no lock of its own: a 64-bit update is two word
+// writes, so callers serialize every call, the way Main.c only touches
+// it while holding CubeDrawing.  No interrupt uses it.
+
+#ifndef __GRID_H__
+#define __GRID_H__
+
+#include <stdint.h>
+
+#define GRID_COLUMNS 6  // 1 to 8
+#define GRID_ROWS 6     // 1 to 8
+
+#if (GRID_COLUMNS < 1) || (GRID_COLUMNS > 8) || (GRID_ROWS < 1) || (GRID_ROWS > 8)
+#error "the grid must fit in 8 x 8 cells"
+#endif
+
+// direction bits, in the same order as enum Direction in Main.c
+#define GRID_UP 0x01
+#define GRID_DOWN 0x02
+#define GRID_LEFT 0x04
+#define GRID_RIGHT 0x08
+
+#define GRID_BIT(x, y) ((uint64_t)1 << ((y)*8 + (x)))
+#define GRID_COL0 0x0101010101010101ULL  // column 0 of every row
+#define GRID_COLLAST (GRID_COL0 << (GRID_COLUMNS - 1))
+#define GRID_CELLS \
+    ((GRID_COL0 * (0xFFu >> (8 - GRID_COLUMNS))) & (~(uint64_t)0 >> (64 - 8 * GRID_ROWS)))
+
+// ******** Grid_Clear ************
+// mark every cell free
+// input:  none
+// output: none
+void Grid_Clear(void);
+
+// ******** Grid_Occupied ************
+// input:  cell column and row
+// output: 1 if the cell is taken, 0 if free
+int Grid_Occupied(uint32_t x, uint32_t y);
+
+// ******** Grid_Take ************
+// take a free cell
+// input:  cell column and row
+// output: 1 if it was free and is now taken, 0 if it was already taken
+int Grid_Take(uint32_t x, uint32_t y);
+
+// ******** Grid_Release ************
+// input:  cell column and row
+// output: none
+void Grid_Release(uint32_t x, uint32_t y);
+
+// ******** Grid_FreeDirections ************
+// which neighbours of a cell are inside the grid and free
+// input:  cell column and row
+// output: GRID_UP | GRID_DOWN | GRID_LEFT | GRID_RIGHT bits
+uint32_t Grid_FreeDirections(uint32_t x, uint32_t y);
+
+// ******** Grid_Move ************
+// move the occupant of a cell one step, the target must be free
+// input:  cell column and row, one GRID_ direction bit
+// output: 1 if moved, 0 if the target was taken or outside the grid
+int Grid_Move(uint32_t x, uint32_t y, uint32_t dir);
+
+#endif
@@ -0,0 +1,94 @@
+// Hist.c
+// Runs on LM4F120/TM4C123
+// Named latency histograms with log2 bins, see Hist.h
+
+#include <stdint.h>
+#include "os.h"
+#include "Hist.h"
+
+long StartCritical(void);   // previous I bit, disable interrupts
+void EndCritical(long sr);  // restore I bit to previous value
+
+HistType *Hist_List;
+
+void Hist_Init(HistType *hist, const char *name, uint8_t id) {
+    uint32_t i;
+    long sr;
+    hist->Name = name;
+    hist->Id = id;
+    hist->Count = 0;
+    hist->Max = 0;
+    for (i = 0; i < HIST_BINS; i++) {
+        hist->Bins[i] = 0;
+    }
+    sr = StartCritical();
+    hist->Next = Hist_List;
+    Hist_List = hist;
+    EndCritical(sr);
+}
+
+// number of significant bits in time, 0 for 0, a five step binary search
+static uint32_t Log2Bin(unsigned long time) {
+    uint32_t bin = 0;
+    if (time == 0) return 0;
+    if (time >> 16) {
+        time >>= 16;
+        bin += 16;
+    }
+    if (time >> 8) {
+        time >>= 8;
+        bin += 8;
+    }
+    if (time >> 4) {
+        time >>= 4;
+        bin += 4;
+    }
+    if (time >> 2) {
+        time >>= 2;
+        bin += 2;
+    }
+    if (time >> 1) {
+        bin += 1;
+    }
+    return bin + 1;
+}
+
+void Hist_Add(HistType *hist, unsigned long time) {
+    uint32_t bin = Log2Bin(time);
+    if (bin >= HIST_BINS) {
+        bin = HIST_BINS - 1;
+    }
+    hist->Bins[bin]++;
+    hist->Count++;
+    if (time > hist->Max) {
+        hist->Max = time;
+    }
+}
+
+unsigned long Hist_Percentile(HistType *hist, uint32_t percent) {
+    unsigned long rank, seen = 0, edge;
+    uint32_t bin;
+    if (hist->Count == 0) return 0;
+    rank = ((unsigned long long)hist->Count * percent + 99) / 100;  // 1-based, rounded up
+    for (bin = 0; bin < HIST_BINS - 1; bin++) {
+        seen += hist->Bins[bin];
+        if (seen >= rank) break;
+    }
+    edge = (bin == 0) ? 0 : (1UL << bin) - 1;  // largest value that lands in this bin
+    return (edge < hist->Max) ? edge : hist->Max;
+}
+
+void Hist_Reset(void) {
+    HistType *hist;
+    uint32_t i;
+    long sr;
+    for (hist = Hist_List; hist; hist = hist->Next) {
+        sr = StartCritical();
+        for (i = 0; i < HIST_BINS; i++) {
+            hist->Bins[i] = 0;
+        }
+        hist->Count = 0;
+        hist->Max = 0;
+        EndCritical(sr);
+    }
+}
@@ -0,0 +1,62 @@
+// Hist.h
+// Runs on LM4F120/TM4C123
+// Named latency histograms with log2 bins.
+// Bin 0 counts zero length intervals and bin n counts intervals of
+// 2^(n-1) to 2^n - 1 OS_Time units (12.5 ns), so HIST_BINS bins cover
+// anything OS_TimeDifference returns in 128 bytes per histogram.
+// Percentiles come back as the upper edge of the bin they fall in,
+// good to a factor of two, and the exact maximum is kept alongside.
+// Hist_Init links every histogram into one list, so the shell and
+// telemetry can walk them by name.
+// Each histogram expects one writer; Hist_Add does not lock.
+
+#ifndef __HIST_H__
+#define __HIST_H__
+
+#include <stdint.h>
+#include "os.h"
+
+#define HIST_BINS 32
+
+struct Hist {
+    const char *Name;
+    uint8_t Id;           // telemetry record id, 0 to leave it out of telemetry
+    unsigned long Count;  // intervals added
+    unsigned long Max;    // longest interval in OS_Time units
+    unsigned long Bins[HIST_BINS];
+    struct Hist *Next;
+};
+typedef struct Hist HistType;
+
+// every initialized histogram, most recent first
+extern HistType *Hist_List;
+
+// time the code between HIST_BEGIN and HIST_END into a histogram
+// start is an unsigned long the caller declares
+#define HIST_BEGIN(start) ((start) = OS_Time())
+#define HIST_END(hist, start) Hist_Add(&(hist), OS_TimeDifference((start), OS_Time()))
+
+// ******** Hist_Init ************
+// clear a histogram and add it to Hist_List, call once per histogram
+// input:  pointer to the histogram, name for the shell, telemetry id or 0
+// output: none
+void Hist_Init(HistType *hist, const char *name, uint8_t id);
+
+// ******** Hist_Add ************
+// count one interval
+// input:  pointer to the histogram, interval in OS_Time units
+// output: none
+void Hist_Add(HistType *hist, unsigned long time);
+
+// ******** Hist_Percentile ************
+// input:  pointer to the histogram, percentile 1 to 100
+// output: upper bound of that percentile in OS_Time units, at most Max, 0 if empty
+unsigned long Hist_Percentile(HistType *hist, uint32_t percent);
+
+// ******** Hist_Reset ************
+// clear the counts of every histogram in Hist_List
+// input:  none
+// output: none
+void Hist_Reset(void);
+
+#endif
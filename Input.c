@@ -0,0 +1,130 @@
+// Input.c
+// Runs on LM4F120/TM4C123
+// Joystick input pipeline, see Input.h
+
+#include <stdint.h>
+#include "Input.h"
+#include "Calibration.h"
+
+long StartCritical(void);   // previous I bit, disable interrupts
+void EndCritical(long sr);  // restore I bit to previous value
+
+#define FILTERBITS 4  // fraction bits of the filter state
+#define NUMSPEEDS (INPUT_MAXSPEED - INPUT_MINSPEED + 1)
+#define STEPBITS 6    // response table has 2^6 entries per speed
+#define STEPPOINTS (1 << STEPBITS)
+#define RECIPDRIFT 16 // center drift in ADC counts before the gains are redone
+
+struct Axis {
+    int32_t state;        // filtered sample, Q4 ADC counts
+    int32_t recipNeg;     // 1 / usable range below the center, Q24
+    int32_t recipPos;     // 1 / usable range above the center, Q24
+    int32_t recipCenter;  // center the reciprocals were computed for
+};
+
+static struct Axis Axes[2];
+static int16_t Steps[NUMSPEEDS][STEPPOINTS];  // cursor step by speed and deflection
+static int32_t DeadZone = INPUT_DEADZONE;
+static uint8_t FilterShift = INPUT_FILTER;
+
+// fill the response table, a mix of linear and cubic response scaled by
+// each speed level, so a sample costs one lookup instead of interpolating
+// a curve and multiplying by the speed
+// INPUT_EXPO of 0 is linear, 256 is fully cubic for fine aiming
+void static StepsInit(int32_t baseSpeed) {
+    int32_t i, s, u, cube, curve, speed;
+    for (s = 0; s < NUMSPEEDS; s++) {
+        speed = s + INPUT_MINSPEED;
+        speed = (speed >= 0) ? (baseSpeed << speed) : (baseSpeed >> -speed);
+        for (i = 0; i < STEPPOINTS; i++) {
+            u = i << (8 - STEPBITS);   // Q8, bottom of the entry
+            cube = (u * u * u) >> 16;  // Q8
+            curve = (u * (256 - INPUT_EXPO) + cube * INPUT_EXPO) >> 8;
+            Steps[s][i] = (curve * speed) >> 8;
+        }
+    }
+}
+
+// reciprocals of the calibrated range past the dead zone, the only divides
+void static AxisRecip(int axisI) {
+    struct Axis *axis = &Axes[axisI];
+    struct CalAxis *cal = &Cal_Axes[axisI];
+    int32_t range;
+    axis->recipCenter = cal->center;
+    range = cal->center - cal->min - DeadZone;
+    axis->recipNeg = (1 << 24) / (range > 64 ? range : 64);  // keeps u within 32 bits
+    range = cal->max - cal->center - DeadZone;
+    axis->recipPos = (1 << 24) / (range > 64 ? range : 64);
+}
+
+void Input_Init(int32_t baseSpeed) {
+    int i;
+    long sr;
+    sr = StartCritical();  // the Producer may be running
+    StepsInit(baseSpeed);
+    for (i = 0; i < 2; i++) {
+        Axes[i].state = Cal_Axes[i].center << FILTERBITS;
+        AxisRecip(i);
+    }
+    EndCritical(sr);
+}
+
+void Input_SetDeadZone(uint16_t counts) {
+    long sr;
+    sr = StartCritical();
+    DeadZone = counts;
+    AxisRecip(0);
+    AxisRecip(1);
+    EndCritical(sr);
+}
+
+void Input_SetFilter(uint8_t shift) {
+    if (shift > FILTERBITS) shift = FILTERBITS;
+    FilterShift = shift;
+}
+
+// feed a sample at rest or past the known range to the calibration, and
+// redo the gains if the range grew or the center moved a long way
+void static AxisTrack(int axisI, int32_t v) {
+    int32_t drift;
+    if (Cal_Track(axisI, v, DeadZone)) {
+        drift = Cal_Axes[axisI].center - Axes[axisI].recipCenter;
+        if ((v < Cal_Axes[axisI].center - DeadZone) || (v > Cal_Axes[axisI].center + DeadZone) ||
+            (drift > RECIPDRIFT) || (drift < -RECIPDRIFT)) {
+            AxisRecip(axisI);
+        }
+    }
+}
+
+// filter one axis and return its step, toward the raw value's sign
+// samples inside the known range cannot move the calibration, so those
+// skip Cal_Track and a moving stick costs a multiply and a table lookup
+int16_t static AxisStep(int axisI, uint16_t raw, int speedI) {
+    struct Axis *axis = &Axes[axisI];
+    struct CalAxis *cal = &Cal_Axes[axisI];
+    int32_t v, d, u;
+    axis->state += (((int32_t)raw << FILTERBITS) - axis->state) >> FilterShift;
+    v = axis->state >> FILTERBITS;
+    d = v - cal->center;
+    if (d > DeadZone) {
+        if (v > cal->max) AxisTrack(axisI, v);  // rare, a new extreme
+        u = ((d - DeadZone) * axis->recipPos) >> (24 - STEPBITS);  // Q(STEPBITS)
+        if (u >= STEPPOINTS) u = STEPPOINTS - 1;  // the center drifted toward an end
+        return Steps[speedI][u];
+    }
+    if (d < -DeadZone) {
+        if (v < cal->min) AxisTrack(axisI, v);
+        u = ((-d - DeadZone) * axis->recipNeg) >> (24 - STEPBITS);
+        if (u >= STEPPOINTS) u = STEPPOINTS - 1;
+        return -Steps[speedI][u];
+    }
+    AxisTrack(axisI, v);  // at rest, the center follows
+    return 0;
+}
+
+void Input_Delta(uint16_t rawx, uint16_t rawy, int speed, int16_t *dx, int16_t *dy) {
+    if (speed < INPUT_MINSPEED) speed = INPUT_MINSPEED;
+    if (speed > INPUT_MAXSPEED) speed = INPUT_MAXSPEED;
+    *dx = AxisStep(0, rawx, speed - INPUT_MINSPEED);
+    *dy = -AxisStep(1, rawy, speed - INPUT_MINSPEED);
+}
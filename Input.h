@@ -0,0 +1,48 @@
+// Input.h
+// Runs on LM4F120/TM4C123
+// Joystick input pipeline, turns raw ADC samples into cursor steps.
+// The ADC already averages 16 conversions in hardware (ADC0_SAC_R in
+// joystick.c); this stage adds a first order IIR low pass filter, a
+// dead zone around the calibrated center (Calibration.h), and scales
+// the deflection past the dead zone by the calibrated range on that
+// side.  The scaled deflection indexes a response curve precomputed
+// for each speed level.  All divides happen in Input_Init or when the
+// range grows or the center drifts, so a sample costs shifts, a
+// multiply and a table lookup per axis.
+
+#ifndef __INPUT_H__
+#define __INPUT_H__
+
+#include <stdint.h>
+
+#define INPUT_MINSPEED -1  // slowest speed level, base speed >> 1
+#define INPUT_MAXSPEED 1   // fastest speed level, base speed << 1
+#define INPUT_DEADZONE 48  // default dead zone in ADC counts (0 to 4095 scale)
+#define INPUT_FILTER 1     // default IIR shift, new = old + (raw - old) / 2^shift
+#define INPUT_EXPO 128     // response curve, 0 is linear, 256 is cubic
+
+// ******** Input_Init ************
+// precompute the response curve and gains, call after Cal_Init
+// input:  cursor step at full deflection
+// output: none
+void Input_Init(int32_t baseSpeed);
+
+// ******** Input_SetDeadZone ************
+// input:  deflection in ADC counts that is treated as rest
+// output: none
+void Input_SetDeadZone(uint16_t counts);
+
+// ******** Input_SetFilter ************
+// input:  IIR shift, 0 turns the filter off, at most 4
+// output: none
+void Input_SetFilter(uint8_t shift);
+
+// ******** Input_Delta ************
+// filter one sample and convert it into a cursor step
+// called from the Producer at every ADC sample
+// input:  raw X and Y, speed level INPUT_MINSPEED to INPUT_MAXSPEED
+//         pointers to store the X and Y steps (Y grows downward)
+// output: none
+void Input_Delta(uint16_t rawx, uint16_t rawy, int speed, int16_t *dx, int16_t *dy);
+
+#endif
@@ -18,6 +18,18 @@
 #include "joystick.h"
 #include "PORTE.h"
 #include "bitmap.h"
+#include "Telemetry.h"
+#include "Shell.h"
+#include "Input.h"
+#include "Calibration.h"
+#include "Grid.h"
+#include "GameState.h"
+#include "Replay.h"
+#include "AutoPlay.h"
+#include "Hist.h"
+#include "Sampler.h"
+#include "Buttons.h"
+#include "Switch.h"
 #include "driverlib/eeprom.h"
 #include "driverlib/sysctl.h"
 #include "driverlib/pin_map.h"
@@ -44,10 +56,10 @@ int16_t prevx, prevy;  // Previous x and y values of the crosshair
 uint8_t select;        // joystick push
 uint8_t area[2];
 
-#define HORIZONAL_NUM_BLOCKS 6
-#define VERTICAL_NUM_BLOCKS 6
+#define HORIZONAL_NUM_BLOCKS GRID_COLUMNS  // set in Grid.h
+#define VERTICAL_NUM_BLOCKS GRID_ROWS
 #define NUM_CUBES 5
-#define SLEEP_TIME 500
+#define SLEEP_TIME 500  // default ms between cube steps, see SleepTime
 #define MAX_CUBE_LIFETIME 20
 #define DEFAULT_LIFE 5
 #define MAX_ATTEMPTS 50  // for cube placement
@@ -55,8 +67,6 @@ uint8_t area[2];
 #define POLY_MASK_32 0xB4BCD35C
 #define POLY_MASK_31 0x7A5BC2E3
 
-// #define DEBUG_CUBE_COLOR
-
 // #define DEBUG
 // #define DEBUG_V
 
@@ -64,31 +74,38 @@ uint8_t area[2];
 #define FREEZE_DUR 2000
 #define CURSOR_BASE_SPEED 6
 
+#define INPUT_EVENTS  // Producer only sends when the input changes, comment out for every tick
+#define HEARTBEAT 5   // ticks between sends while the input is idle, 250 ms
+
 #define USE_NV_LEADERBOARD
 
 enum Direction { UP = 0, DOWN = 1, LEFT = 2, RIGHT = 3 };
 enum PowerUp { NONE = 0, LIFE, XHAIR, SPEED, FREEZE, SLOW };
 
-struct Cube {
-    uint8_t x;
-    uint8_t y;
-    enum Direction dir;
-    uint8_t dead;
-    uint16_t color;
-    uint16_t life;
-    Sema4Type sem;
-    enum PowerUp powerup;
+#define MAX_CUBES (GRID_COLUMNS * GRID_ROWS)  // one per cell at most
+
+// Every cube, one array per field.  UpdateCubes moves them all in one
+// pass, and the crosshair hit check kills them; both hold CubeDrawing
+// while they touch the store, and so does DrawCubes while it reads it.
+struct CubeStore {
+    uint8_t x[MAX_CUBES];
+    uint8_t y[MAX_CUBES];
+    uint8_t dir[MAX_CUBES];      // enum Direction
+    uint8_t life[MAX_CUBES];     // steps left
+    uint8_t powerup[MAX_CUBES];  // enum PowerUp
+    uint8_t alive[MAX_CUBES];
+    uint32_t count;  // entries in use by the current wave
 };
 
-struct Cube cubes[NUM_CUBES];
-
-Sema4Type blocks[VERTICAL_NUM_BLOCKS][HORIZONAL_NUM_BLOCKS];
+struct CubeStore Cubes;
+uint32_t CubesPerWave = NUM_CUBES;  // first wave, later waves have 1 to CubesPerWave-1
 
 unsigned long NumCreated;     // Number of foreground threads created
 unsigned long UpdateWork;     // Incremented every update on position values
 unsigned long Calculation;    // Incremented every cube number calculation
 unsigned long DisplayCount;   // Incremented every time the Display thread prints on LCD
 unsigned long ConsumerCount;  // Incremented every time the Consumer thread prints on LCD
+unsigned long StepCount;      // Incremented every time UpdateCubes moves the cubes
 unsigned long
     Button1RespTime;  // Latency for Task 2 = Time between button1 push and response on LCD
 unsigned long
@@ -98,17 +115,17 @@ unsigned long Button2PushTime;  // Time stamp for when button 2 was pushed
 
 //---------------------User debugging-----------------------
 unsigned long DataLost;  // data sent by Producer, but not received by Consumer
-long MaxJitter;          // largest time jitter between interrupts in usec
-#define JITTERSIZE 64
-unsigned long const JitterSize = JITTERSIZE;
-unsigned long JitterHistogram[JITTERSIZE] = {
-    0,
-};
 unsigned long TotalWithI1;
 unsigned short MaxWithI1;
+HistType ConsumerHist;  // time from a crosshair sample to its drawing
+HistType DrawHist;      // time from a redraw request to the cubes drawn
+HistType StepHist;      // one StepCubes pass, with CubeDrawing held
+HistType WaveHist;      // one InitCubes placement
+HistType ClearHist;     // one cube cleared on the LCD, with LCDFree held
+HistType DeferHist;     // time from a joystick sample to its Producer run in the OS worker
+HistType ProducerHist;  // one Producer run, up to its OS_Suspend
 
-unsigned long Score;
-unsigned long Life;
+unsigned long SleepTime = SLEEP_TIME;  // ms between cube steps, tunable from the shell
 
 static uint32_t lfsr32;
 static uint32_t lfsr31;
@@ -136,71 +153,25 @@ uint32_t get_rand(void) {
 
 enum Direction get_random_direction() { return (enum Direction)(get_rand() % 4); }
 
-Sema4Type NeedCubeRedraw;
-Sema4Type MoveCubesSem;
-Sema4Type DoneMovingCubesSem;
-Sema4Type ThrottleSem;
+// game state transitions, threads test or wait on these instead of
+// polling Life, restarting and scoring under semaphores
+FlagsType GameFlags;
+#define GAME_OVER 0x01     // Life reached zero
+#define GAME_RESTART 0x02  // Restart is tearing the game down
+#define GAME_SAVE 0x04     // SW1 pressed again while entering initials
+#define GAME_REDRAW 0x08   // the cubes or the crosshair moved, DrawCubes has work
+#define GAME_ENDED (GAME_OVER | GAME_RESTART)
+
 Sema4Type CubeDrawing;
-Sema4Type InfoSem;
-Sema4Type DoneSem;
-Sema4Type MoveWaitSem;
-
-int CheckLife(void) {
-    int res;
-    OS_bWait(&InfoSem);
-    res = Life;
-    OS_bSignal(&InfoSem);
-    return res;
-}
+BarrierType GameOver;  // Consumer, UpdateCubes, DrawCubes and Restart meet here
+
+// 1 while the current game is being played, reads one word, no semaphore
+int GameRunning(void) { return (OS_FlagsPeek(&GameFlags) & GAME_ENDED) == 0; }
+
 static uint32_t restarting = 0;
 static uint32_t scoring = 0;
 Sema4Type ResSem;
 
-int CheckRestarting() {
-    int res;
-    OS_bWait(&ResSem);
-    res = restarting;
-    OS_bSignal(&ResSem);
-    return res;
-}
-int CheckScoring() {
-    int res;
-    OS_bWait(&ResSem);
-    res = scoring;
-    OS_bSignal(&ResSem);
-    return res;
-}
-
-// Must have CubeLock when calling
-int get_movable_directions(struct Cube *cube, int8_t *dirs) {
-    int total = 0;
-    if (cube->x > 0 && blocks[cube->y][cube->x - 1].Value) {
-        total += 1;
-        dirs[LEFT] = 1;
-    } else {
-        dirs[LEFT] = 0;
-    }
-    if (cube->x < HORIZONAL_NUM_BLOCKS - 1 && blocks[cube->y][cube->x + 1].Value) {
-        total += 1;
-        dirs[RIGHT] = 1;
-    } else {
-        dirs[RIGHT] = 0;
-    }
-    if (cube->y > 0 && blocks[cube->y - 1][cube->x].Value) {
-        total += 1;
-        dirs[UP] = 1;
-    } else {
-        dirs[UP] = 0;
-    }
-    if (cube->y < VERTICAL_NUM_BLOCKS - 1 && blocks[cube->y + 1][cube->x].Value) {
-        total += 1;
-        dirs[DOWN] = 1;
-    } else {
-        dirs[DOWN] = 0;
-    }
-    return total;
-}
-
 void Fatal(char *msg, char *msg2) {
     BSP_LCD_DrawString(0, 0, "FATAL ERROR:", LCD_RED);
     BSP_LCD_DrawString(0, 1, msg, LCD_RED);
@@ -212,342 +183,215 @@ void Fatal(char *msg, char *msg2) {
 static const uint16_t block_width = 18;
 static const uint16_t block_height = 18;
 
-void ClearBlockLCD(struct Cube *cube, char *msg) {
+void ClearCubeLCD(int i) {
     int16_t px, py, w, h;
+    unsigned long start;
     OS_bWait(&LCDFree);
-    if (cube->dead) Fatal("Called ClearBlockLCD", msg);
-    px = cube->x * block_width;
-    py = cube->y * block_height;
+    HIST_BEGIN(start);
+    px = Cubes.x[i] * block_width;
+    py = Cubes.y[i] * block_height;
     w = block_width;
     h = block_height;
     BSP_LCD_FillRect(px, py, w, h, LCD_BLACK);
+    HIST_END(ClearHist, start);
     OS_bSignal(&LCDFree);
 }
-void KillCube(struct Cube *cube) {
-    cube->dead = 1;
-    OS_bSignal(&blocks[cube->y][cube->x]);
+void KillCube(int i) {
+    Cubes.alive[i] = 0;
+    Grid_Release(Cubes.x[i], Cubes.y[i]);
 }
 
-Sema4Type reset_crosshair_sem;
-Sema4Type reset_crosshair_thr;
-static int crosshair_size = 4;
-int reset_crosshair_id = 0;
-void ResetCrosshairSize() {
-    int id, id2;
-    OS_bWait(&reset_crosshair_sem);
-    id = reset_crosshair_id;
-    crosshair_size = LARGE_XHAIR;
-    OS_bSignal(&reset_crosshair_sem);
-    OS_bSignal(&reset_crosshair_thr);
-    OS_Sleep(5000);
-    OS_bWait(&reset_crosshair_sem);
-    id2 = reset_crosshair_id;
-    if (id == id2) {
-        // reset crosshair size if no other xhair powerup has been picked up
-        crosshair_size = 4;
-    }
-    OS_bSignal(&reset_crosshair_sem);
-    OS_Kill();
+// power-ups wear off through software timers, picking up the same kind
+// again restarts its timer instead of racing a second reset thread
+#define SMALL_XHAIR 4
+#define XHAIR_DUR 5000
+#define SPEED_DUR 2000
+OSTimerType CrosshairTimer;
+OSTimerType SpeedTimer;  // shared by SPEED and SLOW, the last one picked up wins
+OSTimerType FreezeTimer;
+
+void ResetCrosshairSize(void) {
+    long sr;
+    sr = GameState_BeginWrite();
+    Game.CrosshairSize = SMALL_XHAIR;
+    GameState_EndWrite(sr);
 }
 
-Sema4Type reset_speed_sem;
-Sema4Type reset_speed_thr;
-static int speed = 0;
-int reset_speed_id = 0;
-void ResetSpeed() {
-    int id, id2;
-    OS_bWait(&reset_speed_sem);
-    id = reset_speed_id;
-    speed = 1;
-    OS_bSignal(&reset_speed_sem);
-    OS_bSignal(&reset_speed_thr);
-    OS_Sleep(2000);
-    OS_bWait(&reset_speed_sem);
-    id2 = reset_speed_id;
-    if (id == id2) {
-        // reset crosshair size if no other xhair powerup has been picked up
-        speed = 0;
-    }
-    OS_bSignal(&reset_speed_sem);
-    OS_Kill();
+void ResetSpeed(void) {
+    long sr;
+    sr = GameState_BeginWrite();
+    Game.Speed = 0;
+    GameState_EndWrite(sr);
 }
-void SlowDown() {
-    int id, id2;
-    OS_bWait(&reset_speed_sem);
-    id = reset_speed_id;
-    speed = -1;
-    OS_bSignal(&reset_speed_sem);
-    OS_bSignal(&reset_speed_thr);
-    OS_Sleep(2000);
-    OS_bWait(&reset_speed_sem);
-    id2 = reset_speed_id;
-    if (id == id2) {
-        // reset crosshair size if no other xhair powerup has been picked up
-        speed = 0;
-    }
-    OS_bSignal(&reset_speed_sem);
-    OS_Kill();
+
+void Unfreeze(void) {
+    long sr;
+    sr = GameState_BeginWrite();
+    Game.Frozen = 0;
+    GameState_EndWrite(sr);
 }
 
-static int frozen = 0;
-int freeze_id = 0;
-Sema4Type freeze_sem;
-Sema4Type freeze_thr;
-void Freeze() {
-    int id, id2;
-    OS_bWait(&freeze_sem);
-    id = freeze_id;
-    frozen = 1;
-    OS_bSignal(&freeze_sem);
-    OS_bSignal(&freeze_thr);
-    OS_Sleep(FREEZE_DUR);
-    OS_bWait(&freeze_sem);
-    id2 = freeze_id;
-    if (id == id2) {
-        // reset crosshair size if no other xhair powerup has been picked up
-        frozen = 0;
-    }
-    OS_bSignal(&freeze_sem);
-    OS_Kill();
+// create the power-up timers, once at boot
+void PowerUp_Init(void) {
+    OS_TimerCreate(&CrosshairTimer, &ResetCrosshairSize, 0);
+    OS_TimerCreate(&SpeedTimer, &ResetSpeed, 0);
+    OS_TimerCreate(&FreezeTimer, &Unfreeze, 0);
+}
+
+// cancel every running power-up, called on restart
+void PowerUp_Cancel(void) {
+    OS_TimerCancel(&CrosshairTimer);
+    OS_TimerCancel(&SpeedTimer);
+    OS_TimerCancel(&FreezeTimer);
 }
 
-void HandlePowerUp(struct Cube *cube) {
-    switch (cube->powerup) {
+// start the power-up of cube i, called once per hit
+void HandlePowerUp(int i) {
+    long sr;
+    sr = GameState_BeginWrite();
+    switch (Cubes.powerup[i]) {
         case NONE:
             break;
         case LIFE:
-            Life += 1;
+            Game.Life += 1;
             break;
         case XHAIR:
-            OS_bWait(&reset_crosshair_sem);
-            reset_crosshair_id++;
-            OS_AddThread(&ResetCrosshairSize, 128, 6);
-            OS_bSignal(&reset_crosshair_sem);
-            OS_bWait(&reset_crosshair_thr);
+            Game.CrosshairSize = LARGE_XHAIR;
+            OS_TimerRestart(&CrosshairTimer, XHAIR_DUR);
             break;
         case SPEED:
-            OS_bWait(&reset_speed_sem);
-            reset_speed_id++;
-            OS_AddThread(&ResetSpeed, 128, 6);
-            OS_bSignal(&reset_speed_sem);
-            OS_bWait(&reset_speed_thr);
+            Game.Speed = 1;
+            OS_TimerRestart(&SpeedTimer, SPEED_DUR);
             break;
         case FREEZE:
-            OS_bWait(&freeze_sem);
-            freeze_id++;
-            OS_AddThread(&Freeze, 128, 6);
-            OS_bSignal(&freeze_sem);
-            OS_bWait(&freeze_thr);
+            Game.Frozen = 1;
+            OS_TimerRestart(&FreezeTimer, FREEZE_DUR);
             break;
         case SLOW:
-            OS_bWait(&reset_speed_sem);
-            reset_speed_id++;
-            OS_AddThread(&SlowDown, 128, 6);
-            OS_bSignal(&reset_speed_sem);
-            OS_bWait(&reset_speed_thr);
+            Game.Speed = -1;
+            OS_TimerRestart(&SpeedTimer, SPEED_DUR);
             break;
     }
+    GameState_EndWrite(sr);
 }
 
-int CheckBlockIntersection(struct Cube *cube) {
-    int px, py;
-    px = cube->x * block_width;
-    py = cube->y * block_height;
-    OS_bWait(&reset_crosshair_sem);
-    if (x + crosshair_size >= px && x - crosshair_size <= px + block_width) {
-        if (y + crosshair_size >= py && y - crosshair_size <= py + block_height) {
-            OS_bSignal(&reset_crosshair_sem);
-            ClearBlockLCD(cube, "CheckInt");
-            KillCube(cube);
-            OS_bWait(&InfoSem);
-            Score += 1;
-            HandlePowerUp(cube);
-            OS_bSignal(&InfoSem);
+// kill cube i if the crosshair covers it
+int CheckCubeHit(int i) {
+    int px, py, size;
+    long sr;
+    px = Cubes.x[i] * block_width;
+    py = Cubes.y[i] * block_height;
+    size = Game.CrosshairSize;  // one word, no snapshot needed
+    if (x + size >= px && x - size <= px + block_width) {
+        if (y + size >= py && y - size <= py + block_height) {
+            ClearCubeLCD(i);
+            KillCube(i);
+            sr = GameState_BeginWrite();
+            Game.Score += 1;
+            GameState_EndWrite(sr);
+            HandlePowerUp(i);
             return 1;
         }
     }
-    OS_bSignal(&reset_crosshair_sem);
     return 0;
 }
 
-void MoveCube(struct Cube *cube) {
-    int8_t valid_directions[4];
-    int dir_to_move_num;
-    int new_x, new_y;
-    int i;
-    int total_valid_dirs;
-    int32_t status;
-    if (cube->dead) return;
-    status = StartCritical();
-    total_valid_dirs = get_movable_directions(cube, valid_directions);
-    if (!total_valid_dirs) {
-#ifdef DEBUG_CUBE_COLOR
-        cube->color = LCD_YELLOW;
-#endif
-        EndCritical(status);
-        return;
+// check every live cube against the crosshair, call with CubeDrawing
+// after the crosshair moves and after the cubes move
+void CheckCrosshairHits(void) {
+    uint32_t i;
+    for (i = 0; i < Cubes.count; ++i) {
+        if (Cubes.alive[i]) CheckCubeHit(i);
     }
+}
 
-    if (valid_directions[cube->dir]) {
-#ifdef DEBUG_CUBE_COLOR
-        cube->color = LCD_WHITE;
-#endif
-    } else {
-#ifdef DEBUG_CUBE_COLOR
-        cube->color = LCD_RED;
-#endif
-        dir_to_move_num = get_rand() % total_valid_dirs;
+// what the autoplay bot sees, called from the Producer, which must not
+// hold up the OS worker thread, so it reads the cube store without
+// CubeDrawing; a cube that moves during the scan only misaims the bot
+// for one sample
+void AutoPlayLook(struct AutoPlayView *view) {
+    uint32_t i, d, best = 0xFFFFFFFF;
+    int32_t cx, cy;
+    view->x = x;
+    view->y = y;
+    view->target = 0;
+    view->over = (OS_FlagsPeek(&GameFlags) & GAME_OVER) != 0;
+    for (i = 0; i < Cubes.count; ++i) {
+        if (!Cubes.alive[i]) continue;
+        cx = Cubes.x[i] * block_width + block_width / 2;
+        cy = Cubes.y[i] * block_height + block_height / 2;
+        d = (cx - x) * (cx - x) + (cy - y) * (cy - y);
+        if (d < best) {
+            best = d;
+            view->targetX = cx;
+            view->targetY = cy;
+            view->target = 1;
+        }
+    }
+}
 
-        for (i = 0; i < 4; ++i) {
-            if (!valid_directions[i]) continue;
-            if (--dir_to_move_num < 0) {
-                cube->dir = (enum Direction)i;
-                break;
-            }
+// move cube i one step, straight ahead if it can, else in a random free direction
+void MoveCube(int i) {
+    uint32_t free = Grid_FreeDirections(Cubes.x[i], Cubes.y[i]);  // bit n is enum Direction n
+    uint32_t dir, n, total = 0;
+    if (!free) return;  // boxed in, wait for a neighbour to move
+    if (!(free & (1 << Cubes.dir[i]))) {
+        for (dir = 0; dir < 4; ++dir) {
+            total += (free >> dir) & 1;
         }
-        if (i == 4) {
-            Fatal("Couldn't find dir", "");
+        n = get_rand() % total;
+        for (dir = 0; dir < 4; ++dir) {
+            if (((free >> dir) & 1) && (n-- == 0)) break;
         }
+        Cubes.dir[i] = dir;
     }
-
-    new_x = cube->x;
-    new_y = cube->y;
-
-    switch (cube->dir) {
+    Grid_Move(Cubes.x[i], Cubes.y[i], 1 << Cubes.dir[i]);
+    switch (Cubes.dir[i]) {
         case UP:
-            new_y -= 1;
+            Cubes.y[i] -= 1;
             break;
         case DOWN:
-            new_y += 1;
+            Cubes.y[i] += 1;
             break;
         case LEFT:
-            new_x -= 1;
+            Cubes.x[i] -= 1;
             break;
         case RIGHT:
-            new_x += 1;
+            Cubes.x[i] += 1;
             break;
     }
-    OS_bWait(&blocks[new_y][new_x]);  // this should never block
-    OS_bSignal(&blocks[cube->y][cube->x]);
-    EndCritical(status);
-    // ClearBlockLCD(cube);
-    cube->y = new_y;
-    cube->x = new_x;
-}
-
-Sema4Type CheckIntSem;
-int CheckIntOk = 0;
-
-int CanCheckIntersectionAndHold() {
-    OS_bWait(&CheckIntSem);
-    if (!CheckIntOk) {
-        OS_bSignal(&CheckIntSem);
-        return 0;
-    }
-    return CheckIntOk;
 }
 
 void DecLife() {
-    OS_bWait(&InfoSem);
-    if (Life) {
-        Life--;
-        if (!Life) {
-            // Game over
-            OS_bWait(&LCDFree);
-            BSP_LCD_FillScreen(BGCOLOR);
-            BSP_LCD_DrawString(6, 4, "Game over!", LCD_RED);
-            BSP_LCD_Message(0, 6, 5, "Score: ", Score);
-            BSP_LCD_DrawString(2, 8, "Press SW1 to save", LCD_WHITE);
-            BSP_LCD_DrawString(1, 9, "Press SW2 to restart", LCD_WHITE);
-            OS_bSignal(&LCDFree);
-        }
+    int over = 0;
+    long sr;
+    sr = GameState_BeginWrite();
+    if (Game.Life) {
+        Game.Life--;
+        over = (Game.Life == 0);
     }
-    OS_bSignal(&InfoSem);
-}
-
-static int reinit = 0;
-
-void MoveCubeThread(struct Cube *cube) {
-    while (CheckLife() > 0 && !cube->dead && !CheckRestarting() && !reinit) {
-        while (!cube->dead && !MoveCubesSem.Value && !CheckRestarting() && !reinit) {
-            if (CanCheckIntersectionAndHold()) {
-                int res;
-                OS_bWait(&cube->sem);
-                res = CheckBlockIntersection(cube);
-                OS_bSignal(&cube->sem);
-                OS_bSignal(&CheckIntSem);
-                if (res) break;
-            }
-            OS_Suspend();
-        }
-        if (reinit || CheckRestarting()) break;
-        OS_bWait(&cube->sem);
-        if (cube->dead) {
-            OS_bSignal(&cube->sem);
-            break;
-        }
-        OS_bSignal(&cube->sem);
-        OS_Wait(&MoveCubesSem);
-        if (reinit || CheckRestarting()) break;
-        OS_bWait(&cube->sem);
-        if (!cube->dead && frozen == 0) {
-            MoveCube(cube);
-            cube->life--;
-            if (!cube->life) {
-                KillCube(cube);
-                if (cube->powerup != SLOW) DecLife();
-            }
-        }
-        OS_bSignal(&cube->sem);
-        OS_Signal(&DoneMovingCubesSem);
-        OS_Wait(&ThrottleSem);
+    GameState_EndWrite(sr);
+    if (over) {
+        // Game over
+        OS_FlagsSet(&GameFlags, GAME_OVER | GAME_REDRAW);
+        Replay_Flush();  // the session so far is complete in the capture
+        OS_bWait(&LCDFree);
+        BSP_LCD_FillScreen(BGCOLOR);
+        BSP_LCD_DrawString(6, 4, "Game over!", LCD_RED);
+        BSP_LCD_Message(0, 6, 5, "Score: ", Game.Score);
+        BSP_LCD_DrawString(2, 8, "Press SW1 to save", LCD_WHITE);
+        BSP_LCD_DrawString(1, 9, "Press SW2 to restart", LCD_WHITE);
+        OS_bSignal(&LCDFree);
     }
-    OS_Signal(&MoveWaitSem);
 }
 
-void MoveCube0(void) {
-    struct Cube *cube = &cubes[0];
-    MoveCubeThread(cube);
-    OS_Kill();
-}
-void MoveCube1(void) {
-    struct Cube *cube = &cubes[1];
-    MoveCubeThread(cube);
-    OS_Kill();
-}
-void MoveCube2(void) {
-    struct Cube *cube = &cubes[2];
-    MoveCubeThread(cube);
-    OS_Kill();
-}
-void MoveCube3(void) {
-    struct Cube *cube = &cubes[3];
-    MoveCubeThread(cube);
-    OS_Kill();
-}
-void MoveCube4(void) {
-    struct Cube *cube = &cubes[4];
-    MoveCubeThread(cube);
-    OS_Kill();
-}
-
-static int run_once = 0;
-static int num_last_created = NUM_CUBES;
-void InitCubes(int num_cubes) {
-    int y, x, i;
-    void (*move_cube[5])(void) = {&MoveCube0, &MoveCube1, &MoveCube2, &MoveCube3, &MoveCube4};
-    num_last_created = num_cubes;
-    OS_InitSemaphore(&MoveWaitSem, 0);
-    OS_InitSemaphore(&CheckIntSem, 1);
-    CheckIntOk = 0;
-    // initialize data structures
-    for (y = 0; y < VERTICAL_NUM_BLOCKS; ++y) {
-        for (x = 0; x < HORIZONAL_NUM_BLOCKS; ++x) {
-            // if (run_once && blocks[y][x].Value != 1) Fatal("Sema not 1", "");
-            OS_InitSemaphore(&blocks[y][x], 1);
-        }
-    }
-    run_once++;
+// start a wave of num_cubes cubes on free cells
+void InitCubes(uint32_t num_cubes) {
+    uint32_t i;
+    unsigned long start;
+    HIST_BEGIN(start);
+    if (num_cubes > MAX_CUBES) num_cubes = MAX_CUBES;
+    Grid_Clear();
 #ifdef DEBUG
     BSP_LCD_Message(0, 2, 0, "Making cubes: ", num_cubes);
 #endif
@@ -559,45 +403,37 @@ void InitCubes(int num_cubes) {
         do {
             x = get_rand() % HORIZONAL_NUM_BLOCKS;
             y = get_rand() % VERTICAL_NUM_BLOCKS;
-#ifdef DEBUG
-            BSP_LCD_Message(0, 4, 0, "attempt: ", attempt);
-            BSP_LCD_Message(0, 5, 0, "x: ", x);
-            BSP_LCD_Message(0, 6, 0, "y: ", y);
-            OS_Sleep(50);
-#endif
-            if (attempt++ > MAX_ATTEMPTS) {
-                Fatal("Ran out of attempts", "RNG is broken");
+            if (attempt++ > MAX_ATTEMPTS) {  // crowded grid, take the first free cell
+                for (y = 0; y < VERTICAL_NUM_BLOCKS; ++y) {
+                    for (x = 0; x < HORIZONAL_NUM_BLOCKS; ++x) {
+                        if (!Grid_Occupied(x, y)) break;
+                    }
+                    if (x < HORIZONAL_NUM_BLOCKS) break;
+                }
             }
-        } while (!blocks[y][x].Value);  // keep picking new coordinates until the position is free
-        OS_bWait(&blocks[y][x]);
-        cubes[i].x = x;
-        cubes[i].y = y;
-        cubes[i].dead = 0;
-        cubes[i].dir = get_random_direction();
-        cubes[i].life = 1 + (get_rand() % (MAX_CUBE_LIFETIME - 1));
+        } while (!Grid_Take(x, y));  // keep picking new coordinates until the position is free
+        Cubes.x[i] = x;
+        Cubes.y[i] = y;
+        Cubes.alive[i] = 1;
+        Cubes.dir[i] = get_random_direction();
+        Cubes.life[i] = 1 + (get_rand() % (MAX_CUBE_LIFETIME - 1));
         powerup_rand = get_rand() % 10;
         if (powerup_rand == 0) {
-            cubes[i].color = LCD_RED;
-            cubes[i].powerup = LIFE;
+            Cubes.powerup[i] = LIFE;
         } else if (powerup_rand == 1) {
-            cubes[i].color = LCD_GREEN;
-            cubes[i].powerup = XHAIR;
+            Cubes.powerup[i] = XHAIR;
         } else if (powerup_rand == 2) {
-            cubes[i].color = LCD_YELLOW;
-            cubes[i].powerup = SPEED;
+            Cubes.powerup[i] = SPEED;
         } else if (powerup_rand == 3) {
-            cubes[i].color = LCD_CYAN;
-            cubes[i].powerup = FREEZE;
+            Cubes.powerup[i] = FREEZE;
         } else if (powerup_rand == 4) {
-            cubes[i].color = LCD_GREY;
-            cubes[i].powerup = SLOW;
+            Cubes.powerup[i] = SLOW;
         } else {
-            cubes[i].color = LCD_BLUE;
-            cubes[i].powerup = NONE;
+            Cubes.powerup[i] = NONE;
         }
-        OS_InitSemaphore(&cubes[i].sem, 1);
-        OS_AddThread(move_cube[i], 128, 3);
     }
+    Cubes.count = num_cubes;
+    HIST_END(WaveHist, start);
 }
 
 void ClearLCDBlocks() {
@@ -605,119 +441,87 @@ void ClearLCDBlocks() {
                      LCD_BLACK);
 }
 
-void InitAndSyncBlocks(void) {
-    int i;
-    int8_t live_or_dying_cubes[NUM_CUBES] = {0};
-    InitCubes(NUM_CUBES);
-    OS_bSignal(&CubeDrawing);
-    while (CheckLife() > 0) {
-        int num_alive = 0;
-        OS_bWait(&CheckIntSem);
-        CheckIntOk = 1;
-        OS_bSignal(&CheckIntSem);
-        OS_bSignal(&NeedCubeRedraw);
-        OS_Sleep(SLEEP_TIME);
-
-        OS_bWait(&CheckIntSem);
-        CheckIntOk = 0;
-        OS_bSignal(&CheckIntSem);
-
-        if (CheckRestarting()) break;
-
-        OS_bWait(&CubeDrawing);
-
-        for (i = 0; i < NUM_CUBES; ++i) {
-            OS_bWait(&cubes[i].sem);
-            if (cubes[i].dead) {
-                live_or_dying_cubes[i] = 0;
-                OS_bSignal(&cubes[i].sem);
-                continue;
-            }
-            ClearBlockLCD(&cubes[i], "Premove");
-            live_or_dying_cubes[i] = 1;
-            OS_bSignal(&cubes[i].sem);
+// one game step: clear, move and age every live cube in one pass
+// call with CubeDrawing
+// returns the number of cubes still alive
+uint32_t StepCubes(void) {
+    uint32_t i, num_alive = 0;
+    int frozen = Game.Frozen;
+    unsigned long start;
+    HIST_BEGIN(start);
+    for (i = 0; i < Cubes.count; ++i) {
+        if (Cubes.alive[i]) ClearCubeLCD(i);
+    }
+    for (i = 0; i < Cubes.count; ++i) {
+        if (!Cubes.alive[i] || frozen) continue;
+        MoveCube(i);
+        Cubes.life[i]--;
+        if (!Cubes.life[i]) {
+            KillCube(i);
+            if (Cubes.powerup[i] != SLOW) DecLife();
         }
+    }
+    CheckCrosshairHits();  // a cube may have moved under the crosshair
+    for (i = 0; i < Cubes.count; ++i) {
+        num_alive += Cubes.alive[i];
+    }
+    HIST_END(StepHist, start);
+    return num_alive;
+}
 
-        for (i = 0; i < NUM_CUBES; ++i) {
-            if (!live_or_dying_cubes[i]) continue;
-            OS_Signal(&MoveCubesSem);
-        }
-        for (i = 0; i < NUM_CUBES; ++i) {
-            if (!live_or_dying_cubes[i]) continue;
-            OS_Wait(&DoneMovingCubesSem);
-        }
-        for (i = 0; i < NUM_CUBES; ++i) {
-            if (!live_or_dying_cubes[i]) continue;
-            OS_Signal(&ThrottleSem);
-        }
+// the game thread, moves every cube once per SleepTime
+void UpdateCubes(void) {
+    InitCubes(CubesPerWave);
+    OS_bSignal(&CubeDrawing);
+    while (GameRunning()) {
+        OS_FlagsSet(&GameFlags, GAME_REDRAW);
+        OS_SetPeriod(SleepTime, SleepTime);  // each step is due before the next one
+        OS_WaitNextPeriod();
+        if (!GameRunning()) break;
 
-        for (i = 0; i < NUM_CUBES; ++i) {
-            if (cubes[i].dead) continue;
-            num_alive++;
-        }
-        if (!num_alive) {
+        OS_bWait(&CubeDrawing);
+        StepCount++;
+        Replay_Step();  // where the step fell against the joystick samples
+        if (!StepCubes()) {
             OS_Sleep(500);
             OS_bWait(&ResSem);  // do not allow a restart right now
-#ifdef DEBUG_V
-            BSP_LCD_DrawString(0, 0, "About to reinitialize", LCD_WHITE);
-            OS_Sleep(50);
-#endif
-            reinit = 1;
-            for (i = 0; i < num_last_created; ++i) {
-                OS_Signal(&MoveCubesSem);
-#ifdef DEBUG_V
-                BSP_LCD_DrawString(0, 3 + i, "Waiting... ", LCD_WHITE);
-#endif
-                OS_Wait(&MoveWaitSem);
-#ifdef DEBUG_V
-                BSP_LCD_DrawString(10, 3 + i, "Done", LCD_GREEN);
-#endif
-            }
-            reinit = 0;
-            // ClearLCDBlocks();
-            OS_InitSemaphore(&MoveWaitSem, 0);
-            OS_InitSemaphore(&MoveCubesSem, 0);
-#ifdef DEBUG_V
-            BSP_LCD_DrawString(0, 1, "Done waiting", LCD_WHITE);
-            OS_Sleep(50);
-#endif
-            InitCubes(1 + (get_rand() % 4));
-#ifdef DEBUG_V
-            BSP_LCD_DrawString(0, 1, "Done reinit", LCD_WHITE);
-            OS_Sleep(50);
-#endif
+            InitCubes(CubesPerWave > 1 ? 1 + (get_rand() % (CubesPerWave - 1)) : 1);
             OS_bSignal(&ResSem);
+            OS_SetPeriod(0, 0);  // the pause between waves is not a missed step
         }
         OS_bSignal(&CubeDrawing);
     }
+    OS_SetPeriod(0, 0);  // no deadline while it waits at the barrier
 #ifdef DEBUG
-    BSP_LCD_DrawString(0, 9, "MoveBlocks exiting", LCD_WHITE);
+    BSP_LCD_DrawString(0, 9, "UpdateCubes exiting", LCD_WHITE);
 #endif
-    OS_Signal(&DoneSem);
+    OS_BarrierWait(&GameOver);
     OS_Kill();  // done
 }
 
 void DrawCubes(void) {
-    while (CheckLife() > 0) {
-        int i;
-        OS_bWait(&NeedCubeRedraw);
+    while (GameRunning()) {
+        uint32_t i;
+        unsigned long start;
+        OS_FlagsWait(&GameFlags, GAME_REDRAW, OS_FLAGS_ANY | OS_FLAGS_CLEAR);
+        HIST_BEGIN(start);
         OS_bWait(&CubeDrawing);
         OS_bWait(&LCDFree);
-        if (!CheckLife()) {
+        if (!GameRunning()) {
             OS_bSignal(&LCDFree);
             OS_bSignal(&CubeDrawing);
             break;
         }
         // BSP_LCD_FillRect(0, 0, block_width * HORIZONAL_NUM_BLOCKS, block_height *
         // VERTICAL_NUM_BLOCKS, LCD_BLACK);
-        for (i = 0; i < NUM_CUBES; ++i) {
+        for (i = 0; i < Cubes.count; ++i) {
             int16_t px, py, w, h;
-            if (cubes[i].dead) continue;
-            px = cubes[i].x * block_width;
-            py = cubes[i].y * block_height;
+            if (!Cubes.alive[i]) continue;
+            px = Cubes.x[i] * block_width;
+            py = Cubes.y[i] * block_height;
             w = block_width;
             h = block_height;
-            switch (cubes[i].powerup) {
+            switch (Cubes.powerup[i]) {
                 case LIFE:
                     BSP_LCD_DrawBitmap(px, py + h - 1, (uint16_t *)health_bitmap, w, h);
                     break;
@@ -740,13 +544,14 @@ void DrawCubes(void) {
         }
 
         OS_bSignal(&LCDFree);
+        HIST_END(DrawHist, start);
         OS_bSignal(&CubeDrawing);
         OS_Suspend();
     }
 #ifdef DEBUG
     BSP_LCD_DrawString(0, 10, "DrawCubes exiting", LCD_WHITE);
 #endif
-    OS_Signal(&DoneSem);
+    OS_BarrierWait(&GameOver);
     OS_Kill();  // done
 }
 
@@ -754,19 +559,14 @@ void Device_Init(void) {
     UART_Init();
     BSP_LCD_OutputInit();
     BSP_Joystick_Init();
+    Sampler_Init(6);  // all six analog inputs, continuously
 }
 //------------------Task 1--------------------------------
-// background thread executed at 20 Hz
+// the ADC interrupt at 20 Hz defers the Producer to the OS worker thread
 //******** Producer ***************
 int UpdatePosition(uint16_t rawx, uint16_t rawy, jsDataType *data) {
     int16_t deltaX, deltaY;
-    if (speed > 0) {
-        deltaX = (rawx - origin[0]) * (CURSOR_BASE_SPEED << speed) / origin[0];
-        deltaY = (origin[1] - rawy) * (CURSOR_BASE_SPEED << speed) / origin[1];
-    } else {
-        deltaX = (rawx - origin[0]) * (CURSOR_BASE_SPEED >> (-1 * speed)) / origin[0];
-        deltaY = (origin[1] - rawy) * (CURSOR_BASE_SPEED >> (-1 * speed)) / origin[1];
-    }
+    Input_Delta(rawx, rawy, Game.Speed, &deltaX, &deltaY);  // filtered, gains from the calibration
     x += deltaX;
     y += deltaY;
     if (x > 127) {
@@ -786,37 +586,52 @@ int UpdatePosition(uint16_t rawx, uint16_t rawy, jsDataType *data) {
     return 1;
 }
 
-void Producer(void) {
+// bottom half of each joystick sample, runs in the OS worker thread
+// arg is the OS_Time ProducerIsr deferred it at
+void Producer(uint32_t arg) {
     uint16_t rawX, rawY;  // raw adc value
     uint8_t select;
     jsDataType data;
-    unsigned static long LastTime;  // time at previous ADC sample
-    unsigned long thisTime;         // time at current ADC sample
-    long jitter;                    // time between measured and expected, in us
-    BSP_Joystick_Input(&rawX, &rawY, &select);
-    thisTime = OS_Time();                             // current time, 12.5 ns
+    int16_t oldX = x, oldY = y;  // cursor before this sample
+    int send = 1;                // pass this sample to the consumer
+    unsigned long start;         // OS_Time the worker started it
+#ifdef INPUT_EVENTS
+    static jsDataType last;     // last sample sent to the consumer
+    static uint32_t idleTicks;  // ticks since then
+#endif
+    HIST_BEGIN(start);
+    Hist_Add(&DeferHist, OS_TimeDifference(arg, start));
+    BSP_Joystick_Sample(&rawX, &rawY, &select);       // converted by the time we run
+    AutoPlay_Sample(&rawX, &rawY, &select);           // the bot's stick, when it plays
+    Replay_Sample(&rawX, &rawY, &select);             // log it, or swap in the logged one
     UpdateWork += UpdatePosition(rawX, rawY, &data);  // calculation work
-    if (JsFifo_Put(data) == 0) {                      // send to consumer
-        DataLost++;
-    }
-    // calculate jitter
-    if (UpdateWork > 1) {  // ignore timing of first interrupt
-        unsigned long diff = OS_TimeDifference(LastTime, thisTime);
-        if (diff > PERIOD) {
-            jitter = (diff - PERIOD + 4) / 8;  // in 0.1 usec
-        } else {
-            jitter = (PERIOD - diff + 4) / 8;  // in 0.1 usec
-        }
-        if (jitter > MaxJitter) {
-            MaxJitter = jitter;  // in usec
-        }                        // jitter should be 0
-        if (jitter >= JitterSize) {
-            jitter = JITTERSIZE - 1;
+    data.select = select;
+#ifdef INPUT_EVENTS
+    // the filter and dead zone already turn noise into no movement, so
+    // any one pixel move is a real change; the cursor can also be moved
+    // by other threads (HighScore recenters it), so compare both ways
+    idleTicks++;
+    send = (data.x != oldX) || (data.y != oldY) || (data.x != last.x) || (data.y != last.y) ||
+           (data.select != last.select) || (idleTicks >= HEARTBEAT);
+#endif
+    if (send) {
+        if (JsFifo_Put(data) == 0) {  // send to consumer
+            DataLost++;
         }
-        JitterHistogram[jitter]++;
+#ifdef INPUT_EVENTS
+        last = data;
+        idleTicks = 0;
+#endif
+    }
+    HIST_END(ProducerHist, start);
+    if (send) {
+        OS_Suspend();  // let the consumer draw it
     }
-    LastTime = thisTime;
-    OS_Suspend();
+}
+
+// top half, runs in the ADC interrupt once the sample is converted
+void ProducerIsr(void) {
+    OS_Defer(&Producer, OS_Time());  // a full ring counts in OS_DeferDropped
 }
 
 //--------------end of Task 1-----------------------------
@@ -852,7 +667,7 @@ void MergeHighScore(char *letters, int score) {
     i = 0;
     arr[0] = MAGICBIT;
     memcpy(arr + 1, highscores, NUM_HIGHSCORES * sizeof(struct HighScore));
-    EEPROMProgram(arr, 0x0, 40);
+    EEPROMProgram(arr, 0x0, sizeof(arr));
 #endif
 }
 
@@ -876,16 +691,19 @@ void DrawHighScores() {
 // ***********ButtonWork*************
 #define CENTER 64
 void HighScore(void) {
-    int let_idx = 0, j;
+    int let_idx = 0;
     jsDataType data2, data3;
     char letters[3] = {'A', 'A', 'A'};
-    if (CheckLife() != 0) {
+    if (!(OS_FlagsPeek(&GameFlags) & GAME_OVER)) {
         OS_Kill();
         return;
     }
     OS_bWait(&ResSem);
     if (restarting || scoring) {
-        if (scoring == 1) scoring = 2;
+        if (scoring == 1) {
+            scoring = 2;
+            OS_FlagsSet(&GameFlags, GAME_SAVE);
+        }
         OS_bSignal(&ResSem);
         OS_Kill();
         return;
@@ -893,7 +711,7 @@ void HighScore(void) {
     scoring = 1;
     OS_bSignal(&ResSem);
     OS_bWait(&LCDFree);
-    for (j = 0; j < JSFIFOSIZE; ++j) {
+    while (JsFifo_Size() > 0) {  // drop stale samples without waiting for new ones
         JsFifo_Get(&data3);
     }
     x = CENTER;
@@ -901,10 +719,10 @@ void HighScore(void) {
     JsFifo_Get(&data3);
     JsFifo_Get(&data2);
     BSP_LCD_FillScreen(BGCOLOR);
-    BSP_LCD_Message(0, 6, 5, "Score: ", Score);
+    BSP_LCD_Message(0, 6, 5, "Score: ", Game.Score);
     BSP_LCD_DrawString(2, 10, "Press SW1 to save", LCD_WHITE);
     // While SW2 is not pressed a second time
-    while (CheckScoring() != 2) {
+    while (!(OS_FlagsPeek(&GameFlags) & GAME_SAVE)) {
         int i;
         x = CENTER;
         y = CENTER;
@@ -939,23 +757,25 @@ void HighScore(void) {
     OS_bWait(&ResSem);
     scoring = 3;
     OS_bSignal(&ResSem);
-    MergeHighScore(letters, Score);
+    MergeHighScore(letters, Game.Score);
+    Cal_Save();  // keep what this game taught us about the joystick
     DrawHighScores();
     OS_Kill();  // done, OS does not return from a Kill
 }
 
+// what a debounced SW1 press does, also run by a replayed press
+void SW1Action(void) {
+    if (OS_AddThread(&HighScore, 128, 4)) {
+        NumCreated++;
+    }
+    Button1PushTime = OS_MsTime();  // Time stamp
+}
+
 //************SW1Push*************
-// Called when SW1 Button pushed
-// Adds another foreground task
-// background threads execute once and return
+// Called by ButtonThread for a debounced SW1 press
 void SW1Push(void) {
-    if (OS_MsTime() > 250) {  // debounce
-        if (OS_AddThread(&HighScore, 128, 4)) {
-            OS_ClearMsTime();
-            NumCreated++;
-        }
-        OS_ClearMsTime();               // at least 50ms between touches
-        Button1PushTime = OS_MsTime();  // Time stamp
+    if (Replay_Button(1)) {
+        SW1Action();
     }
 }
 
@@ -969,35 +789,38 @@ void SW1Push(void) {
 // inputs:  none
 // outputs: none
 void Consumer(void) {
-    while (CheckLife() > 0) {
+    while (GameRunning()) {
         jsDataType data;
+        struct GameState game;
+        unsigned long start;
         JsFifo_Get(&data);
-        OS_bSignal(&NeedCubeRedraw);
+        HIST_BEGIN(start);
+        OS_FlagsSet(&GameFlags, GAME_REDRAW);
         OS_bWait(&LCDFree);
-        if (!CheckLife()) {
+        if (!GameRunning()) {
             OS_bSignal(&LCDFree);
             break;
         }
 
-        OS_bWait(&reset_crosshair_sem);
-        BSP_LCD_DrawCrosshair(prevx, prevy, LARGE_XHAIR, LCD_BLACK);     // Draw a black crosshair
-        BSP_LCD_DrawCrosshair(data.x, data.y, crosshair_size, LCD_RED);  // Draw a red crosshair
-        OS_bSignal(&reset_crosshair_sem);
-
-        OS_bWait(&InfoSem);
-        BSP_LCD_Message(1, 5, 0, "Score:", Score);
-        BSP_LCD_Message(1, 5, 11, "Life:", Life);
-        OS_bSignal(&InfoSem);
+        GameState_Read(&game);
+        BSP_LCD_DrawCrosshair(prevx, prevy, LARGE_XHAIR, LCD_BLACK);          // Draw a black crosshair
+        BSP_LCD_DrawCrosshair(data.x, data.y, game.CrosshairSize, LCD_RED);  // Draw a red crosshair
+        BSP_LCD_Message(1, 5, 0, "Score:", game.Score);
+        BSP_LCD_Message(1, 5, 11, "Life:", game.Life);
         ConsumerCount++;
         OS_bSignal(&LCDFree);
+        HIST_END(ConsumerHist, start);
         prevx = data.x;
         prevy = data.y;
+        OS_bWait(&CubeDrawing);  // the crosshair moved, check it against the cubes
+        CheckCrosshairHits();
+        OS_bSignal(&CubeDrawing);
         OS_Suspend();
     }
 #ifdef DEBUG
     BSP_LCD_DrawString(0, 11, "Consumer exiting", LCD_WHITE);
 #endif
-    OS_Signal(&DoneSem);
+    OS_BarrierWait(&GameOver);
     OS_Kill();  // done
 }
 
@@ -1006,7 +829,8 @@ void Consumer(void) {
 // one foreground task created with button push
 // ***********ButtonWork2*************
 void Restart(void) {
-    uint32_t StartTime, CurrentTime, ElapsedTime, i;
+    uint32_t StartTime, CurrentTime, ElapsedTime;
+    long sr;
     OS_bWait(&ResSem);
     if (restarting || (scoring > 0 && scoring < 3)) {
         OS_bSignal(&ResSem);
@@ -1016,10 +840,10 @@ void Restart(void) {
     restarting = 1;
     OS_bSignal(&ResSem);
     OS_Sleep(50);  // wait
-    OS_bWait(&InfoSem);
-    Life = 0;  // Kill
-    OS_bSignal(&InfoSem);
-    OS_bSignal(&NeedCubeRedraw);
+    sr = GameState_BeginWrite();
+    Game.Life = 0;  // Kill
+    GameState_EndWrite(sr);
+    OS_FlagsSet(&GameFlags, GAME_RESTART | GAME_REDRAW);  // wake DrawCubes so it can exit
     StartTime = OS_MsTime();
     ElapsedTime = 0;
     OS_bWait(&LCDFree);
@@ -1030,28 +854,13 @@ void Restart(void) {
         ElapsedTime = CurrentTime - StartTime;
         BSP_LCD_DrawString(5, 6, "Restarting", LCD_WHITE);
     }
-    for (i = 0; i < NUM_CUBES; ++i) {
-        OS_Signal(&MoveCubesSem);
-        OS_Signal(&ThrottleSem);
-    }
     OS_bSignal(&LCDFree);
 #ifdef DEBUG
-    for (i = 0; i < 3; ++i) {
-        BSP_LCD_Message(0, i, 0, "Check", i);
-        OS_Wait(&DoneSem);
-        BSP_LCD_DrawString(10, i, "Done", LCD_GREEN);
-    }
-    for (i = 0; i < num_last_created; ++i) {
-        OS_Wait(&MoveWaitSem);
-    }
+    BSP_LCD_Message(0, 0, 0, "Done", GameOver.Arrived);
+    OS_BarrierWait(&GameOver);
     BSP_LCD_DrawString(0, 0, "Restarting!!", LCD_RED);
 #else
-    for (i = 0; i < 3; ++i) {
-        OS_Wait(&DoneSem);
-    }
-    for (i = 0; i < num_last_created; ++i) {
-        OS_Wait(&MoveWaitSem);
-    }
+    OS_BarrierWait(&GameOver);  // the game threads have all exited
 #endif
     OS_bWait(&LCDFree);
     BSP_LCD_FillScreen(BGCOLOR);
@@ -1059,53 +868,61 @@ void Restart(void) {
     // restart
     DataLost = 0;  // lost data between producer and consumer
     UpdateWork = 0;
-    MaxJitter = 0;  // in 1us units
-    Score = 0;
-    Life = DEFAULT_LIFE;
     x = 63;
     y = 63;
 
-    // reset powerups
-    frozen = 0;
-    speed = 0;
-    crosshair_size = 4;
+    // reset score, lives and powerups
+    PowerUp_Cancel();
+    GameState_Init(DEFAULT_LIFE, SMALL_XHAIR);
 
     OS_bSignal(&LCDFree);
 
-    OS_InitSemaphore(&MoveCubesSem, 0);
-    OS_InitSemaphore(&DoneMovingCubesSem, 0);
-    OS_InitSemaphore(&ThrottleSem, 0);
     OS_InitSemaphore(&CubeDrawing, 0);
-    OS_InitSemaphore(&NeedCubeRedraw, 0);
-    OS_InitSemaphore(&InfoSem, 1);
-    OS_InitSemaphore(&reset_crosshair_sem, 1);
-    OS_InitSemaphore(&reset_speed_sem, 1);
-    OS_InitSemaphore(&freeze_sem, 1);
 
     OS_bWait(&ResSem);
     restarting = 0;
     scoring = 0;
+    OS_FlagsClear(&GameFlags, GAME_OVER | GAME_RESTART | GAME_SAVE | GAME_REDRAW);
     OS_bSignal(&ResSem);
 
     OS_AddThread(&Consumer, 128, 1);
-    OS_AddThread(&InitAndSyncBlocks, 128, 1);
+    OS_AddThread(&UpdateCubes, 128, 1);
     OS_AddThread(&DrawCubes, 128, 3);
 
     OS_Kill();  // done, OS does not return from a Kill
 }
 
+// what a debounced SW2 press does, also run by a replayed press
+void SW2Action(void) {
+    if (OS_AddThread(&Restart, 128, 4)) {
+        NumCreated++;
+    }
+    Button2PushTime = OS_MsTime();  // Time stamp
+}
+
 //************SW2Push*************
-// Called when Button2 pushed
-// Adds another foreground task
-// background threads execute once and return
+// Called by ButtonThread for a debounced SW2 press
 void SW2Push(void) {
-    if (OS_MsTime() > 20) {  // debounce
-        if (OS_AddThread(&Restart, 128, 4)) {
-            OS_ClearMsTime();
-            NumCreated++;
+    if (Replay_Button(2)) {
+        SW2Action();
+    }
+}
+
+static int SW1Button, SW2Button;  // Buttons.c indexes
+
+//************ButtonThread*************
+// foreground thread, runs the action of each debounced button press
+// releases and long presses do nothing in the game
+void ButtonThread(void) {
+    struct ButtonEvent event;
+    while (1) {
+        Buttons_Get(&event);
+        if (event.Type != BUTTON_PRESS) continue;
+        if (event.Button == SW1Button) {
+            SW1Push();
+        } else if (event.Button == SW2Button) {
+            SW2Push();
         }
-        OS_ClearMsTime();               // at least 20ms between touches
-        Button2PushTime = OS_MsTime();  // Time stamp
     }
 }
 
@@ -1113,11 +930,423 @@ void SW2Push(void) {
 
 // Fill the screen with the background color
 // Grab initial joystick position to bu used as a reference
+// unless a saved calibration is available
 void CrossHair_Init(void) {
     BSP_LCD_FillScreen(BGCOLOR);
     BSP_Joystick_Input(&origin[0], &origin[1], &select);
+    Cal_Init(origin[0], origin[1]);
+    Input_Init(CURSOR_BASE_SPEED);
+}
+
+//------------------Telemetry--------------------------------
+// low priority foreground thread, streams the debugging counters
+// in binary over UART0 instead of printing them in ASCII
+#define TEL_PERIOD 1000  // ms between snapshots
+static int TelemetryOn = 1;  // the shell turns this off so its text is readable
+#ifdef KERNEL_TRACE
+static int TraceDump = 0;    // set by the shell to stream the kernel trace once
+#endif
+void TelemetryThread(void) {
+    uint32_t slot, id, execCount, waitTime;
+    HistType *hist;
+    const PeriodicStatsType *periodic;
+    static struct PeriodicViolation violations[TEL_VIOLATIONCHUNK];  // off the 400 byte stack
+    unsigned long semaOps = OS_SemaphoreOps, violationSeq = 0;
+    int n;
+    OS_SetPeriod(TEL_PERIOD, TEL_PERIOD);
+    while (1) {
+#ifdef KERNEL_TRACE
+        if (TraceDump) {
+            static struct TraceRecord recs[TEL_TRACECHUNK];
+            int n;
+            OS_TraceStop();
+            while ((n = OS_TraceRead(recs, TEL_TRACECHUNK)) > 0) {
+                Tel_Trace(recs, n);
+                Tel_Drain();
+            }
+            OS_TraceStart();
+            TraceDump = 0;
+        }
+#endif
+        if (!TelemetryOn) {
+            OS_WaitNextPeriod();
+            continue;
+        }
+        Tel_Counter(TEL_ID_DATALOST, DataLost);
+        Tel_Counter(TEL_ID_DEFERDROPPED, OS_DeferDropped);
+        Tel_Counter(TEL_ID_SCORE, Game.Score);
+        Tel_Counter(TEL_ID_LIFE, Game.Life);
+        Tel_Counter(TEL_ID_CONSUMERCOUNT, ConsumerCount);
+        Tel_Counter(TEL_ID_UPDATEWORK, UpdateWork);
+        Tel_Counter(TEL_ID_SEMAOPS, OS_SemaphoreOps - semaOps);  // per TEL_PERIOD
+        semaOps = OS_SemaphoreOps;
+        for (slot = 0; (periodic = OS_PeriodicStats(slot)) != 0; slot++) {
+            Tel_Periodic(slot, periodic);
+            Tel_Histogram(TEL_ID_PERIODICJITTER + slot, periodic->Jitter, OS_JITTERSIZE);
+        }
+        while ((n = OS_PeriodicViolations(&violationSeq, violations, TEL_VIOLATIONCHUNK)) > 0) {
+            Tel_Violations(violations, n);  // only the ones since the previous snapshot
+        }
+        for (hist = Hist_List; hist; hist = hist->Next) {
+            if (hist->Id) Tel_Histogram(hist->Id, hist->Bins, HIST_BINS);
+        }
+        if (AutoPlay_Enabled()) {
+            Tel_Counter(TEL_ID_AUTOGAMES, AutoPlay_Games);
+        }
+        for (slot = 0; slot < NUMTHREADS; slot++) {
+            if (OS_ThreadStats(slot, &id, &execCount, &waitTime)) {
+                Tel_Thread(id, execCount, waitTime);
+            }
+        }
+        Tel_Counter(TEL_ID_TELDROPPED, Tel_Dropped);
+        Tel_Drain();
+        OS_WaitNextPeriod();
+    }
 }
 
+//------------------Barrier benchmark--------------------------------
+#define BARRIER_ROUNDS 1000  // timed round trips per run
+
+BarrierType BenchBarrier;
+long volatile BenchWorkers;  // workers that have not finished yet
+
+// every participant but the caller, one warm up round and the timed ones
+void BarrierWorker(void) {
+    int i;
+    long sr;
+    for (i = 0; i <= BARRIER_ROUNDS; i++) {
+        OS_BarrierWait(&BenchBarrier);
+    }
+    sr = StartCritical();
+    BenchWorkers--;
+    EndCritical(sr);
+    OS_Kill();
+}
+
+// ******** BarrierRoundTrip ************
+// time BARRIER_ROUNDS round trips through a barrier shared by the calling
+// thread and participants-1 new worker threads, blocks until they are done
+// input:  number of participants, priority of the workers (the caller's)
+// output: OS_Time units for all the rounds, 0 if a worker could not be added
+unsigned long BarrierRoundTrip(long participants, unsigned long priority) {
+    unsigned long start, elapsed;
+    long i, added;
+    OS_BarrierInit(&BenchBarrier, participants);
+    BenchWorkers = 0;
+    for (added = 1; added < participants; added++) {
+        if (!OS_AddThread(&BarrierWorker, 128, priority)) break;
+        BenchWorkers++;
+    }
+    for (i = added; i < participants; i++) {
+        OS_BarrierLeave(&BenchBarrier);  // the workers that did start still finish
+    }
+    OS_BarrierWait(&BenchBarrier);  // every worker has started
+    start = OS_Time();
+    for (i = 0; i < BARRIER_ROUNDS; i++) {
+        OS_BarrierWait(&BenchBarrier);
+    }
+    elapsed = OS_TimeDifference(start, OS_Time());
+    while (BenchWorkers) {
+        OS_Suspend();  // let them exit and free their slots
+    }
+    return (added == participants) ? elapsed : 0;
+}
+
+//------------------Shell commands--------------------------------
+// game specific commands for the UART shell
+struct NamedSema {
+    char *name;
+    Sema4Type *sema;
+};
+static const struct NamedSema NamedSemas[] = {
+    {"LCDFree", &LCDFree},
+    {"CubeDrawing", &CubeDrawing},
+    {"Res", &ResSem},
+};
+
+void ShowSemas(int argc, char *argv[]) {
+    uint32_t i;
+    for (i = 0; i < sizeof(NamedSemas) / sizeof(NamedSemas[0]); i++) {
+        UART_OutString(NamedSemas[i].name);
+        UART_OutChar(SP);
+        if (NamedSemas[i].sema->Value < 0) {
+            UART_OutChar('-');
+            UART_OutUDec(-NamedSemas[i].sema->Value);
+        } else {
+            UART_OutUDec(NamedSemas[i].sema->Value);
+        }
+        OutCRLF();
+    }
+    UART_OutString("GameOver ");
+    UART_OutUDec(GameOver.Arrived);
+    UART_OutChar('/');
+    UART_OutUDec(GameOver.Count);
+    OutCRLF();
+    UART_OutString("GameFlags ");
+    UART_OutUHex(OS_FlagsPeek(&GameFlags));
+    UART_OutString(" ops ");
+    UART_OutUDec(OS_SemaphoreOps);
+    OutCRLF();
+}
+
+// timing of every periodic task, kept by the OS
+void ShowJitter(int argc, char *argv[]) {
+    const PeriodicStatsType *periodic;
+    struct PeriodicViolation violation;
+    unsigned long seq;
+    uint32_t slot, i;
+    UART_OutString("DataLost ");
+    UART_OutUDec(DataLost);
+    UART_OutString(" DeferDropped ");
+    UART_OutUDec(OS_DeferDropped);
+    OutCRLF();
+    for (slot = 0; (periodic = OS_PeriodicStats(slot)) != 0; slot++) {
+        UART_OutString("periodic ");
+        UART_OutUDec(slot);
+        UART_OutString(" period ");
+        UART_OutUDec(periodic->Period);
+        UART_OutString(" releases ");
+        UART_OutUDec(periodic->Releases);
+        UART_OutString(" MaxJitter ");
+        UART_OutUDec(periodic->MaxJitter);
+        UART_OutString(" MaxExec ");
+        UART_OutUDec(periodic->MaxExec);
+        UART_OutString(" overruns ");
+        UART_OutUDec(periodic->Overruns);
+        if (periodic->Overrun) {
+            UART_OutString(" OVERRUN long ");
+            UART_OutUDec(periodic->LongRuns);
+            UART_OutString(" lost ");
+            UART_OutUDec(periodic->Lost);
+            UART_OutString(" nested ");
+            UART_OutUDec(periodic->Nested);
+        }
+        OutCRLF();
+        for (i = 0; i < OS_JITTERSIZE; i++) {  // in 0.1 usec bins, skip empty ones
+            if (periodic->Jitter[i] == 0) continue;
+            UART_OutUDec(i);
+            UART_OutChar(SP);
+            UART_OutUDec(periodic->Jitter[i]);
+            OutCRLF();
+        }
+    }
+    seq = 0;  // every record still in the ring
+    while (OS_PeriodicViolations(&seq, &violation, 1)) {
+        UART_OutString("violation ");
+        UART_OutUDec(violation.Seq);
+        UART_OutString(" slot ");
+        UART_OutUDec(violation.Slot);
+        UART_OutString(" kind ");
+        UART_OutUDec(violation.Kind);
+        UART_OutString(" start ");
+        UART_OutUDec(violation.Start);
+        UART_OutString(" run ");
+        UART_OutUDec(OS_TimeDifference(violation.Start, violation.Finish));
+        OutCRLF();
+    }
+}
+
+void ResetCounters(int argc, char *argv[]) {
+    long sr;
+    sr = StartCritical();  // Producer updates these in the background
+    DataLost = 0;
+    ConsumerCount = 0;
+    EndCritical(sr);
+    OS_PeriodicReset();
+    Hist_Reset();
+}
+
+// p50, p99 and max of every named histogram, in us
+void ShowHists(int argc, char *argv[]) {
+    HistType *hist;
+    for (hist = Hist_List; hist; hist = hist->Next) {
+        UART_OutString((char *)hist->Name);
+        UART_OutString(" n ");
+        UART_OutUDec(hist->Count);
+        UART_OutString(" p50 ");
+        UART_OutUDec(Hist_Percentile(hist, 50) / (TIME_1MS / 1000));
+        UART_OutString(" p99 ");
+        UART_OutUDec(Hist_Percentile(hist, 99) / (TIME_1MS / 1000));
+        UART_OutString(" max ");
+        UART_OutUDec(hist->Max / (TIME_1MS / 1000));
+        UART_OutString(" us");
+        OutCRLF();
+    }
+}
+
+void SetAutoPlay(int argc, char *argv[]) {
+    uint32_t slot, id, execCount, waitTime, threads = 0;
+    if (argc > 1) {
+        AutoPlay_Enable(strcmp(argv[1], "on") == 0);
+    }
+    for (slot = 0; slot < NUMTHREADS; slot++) {  // a leak shows up as a growing count
+        if (OS_ThreadStats(slot, &id, &execCount, &waitTime)) threads++;
+    }
+    UART_OutString(AutoPlay_Enabled() ? "autoplay on" : "autoplay off");
+    UART_OutString(" games ");
+    UART_OutUDec(AutoPlay_Games);
+    UART_OutString(" threads ");
+    UART_OutUDec(threads);
+    OutCRLF();
+}
+
+void SetCubes(int argc, char *argv[]) {
+    uint32_t n;
+    if (argc > 1) {
+        if (!Shell_ParseNumber(argv[1], &n) || n < 1 || n > MAX_CUBES) {
+            UART_OutString("cubes must be 1 to ");
+            UART_OutUDec(MAX_CUBES);
+            OutCRLF();
+            return;
+        }
+        CubesPerWave = n;  // takes effect with the next wave
+    }
+    UART_OutString("cubes ");
+    UART_OutUDec(CubesPerWave);
+    OutCRLF();
+}
+
+void ShowSampler(int argc, char *argv[]) {
+    uint32_t ch;
+    UART_OutString("blocks ");
+    UART_OutUDec(Sampler_Blocks());
+    UART_OutString(" overflow ");
+    UART_OutUDec(SamplerOverflow);
+    OutCRLF();
+    for (ch = 0; ch < SAMPLER_CHANNELS; ch++) {  // mic, joy x/y, accel x/y/z
+        UART_OutUDec(Sampler_Latest(ch));
+        UART_OutChar(SP);
+    }
+    OutCRLF();
+}
+
+void Calibrate(int argc, char *argv[]) {
+    uint16_t restX, restY;
+    uint8_t sel;
+    int i;
+    if (argc > 1) {
+        if (strcmp(argv[1], "save") == 0) {
+            Cal_Save();
+        } else if (strcmp(argv[1], "reset") == 0) {
+            BSP_Joystick_Input(&restX, &restY, &sel);  // latest sample, leave the stick alone
+            Cal_Reset(restX, restY);
+            Input_Init(CURSOR_BASE_SPEED);
+        } else {
+            UART_OutString("cal [save|reset]");
+            OutCRLF();
+            return;
+        }
+    }
+    for (i = 0; i < 2; i++) {
+        UART_OutString(i ? "y " : "x ");
+        UART_OutUDec(Cal_Axes[i].min);
+        UART_OutChar(SP);
+        UART_OutUDec(Cal_Axes[i].center);
+        UART_OutChar(SP);
+        UART_OutUDec(Cal_Axes[i].max);
+        OutCRLF();
+    }
+}
+
+static uint32_t InputDeadZone = INPUT_DEADZONE;
+static uint32_t InputFilter = INPUT_FILTER;
+
+void SetInput(int argc, char *argv[]) {
+    uint32_t value;
+    if (argc > 1) {
+        if (!Shell_ParseNumber(argv[1], &value) || value > 1000) {
+            UART_OutString("dead zone must be 0 to 1000");
+            OutCRLF();
+            return;
+        }
+        InputDeadZone = value;
+        Input_SetDeadZone(value);
+    }
+    if (argc > 2) {
+        if (!Shell_ParseNumber(argv[2], &value) || value > 4) {
+            UART_OutString("filter must be 0 to 4");
+            OutCRLF();
+            return;
+        }
+        InputFilter = value;
+        Input_SetFilter(value);
+    }
+    UART_OutString("deadzone ");
+    UART_OutUDec(InputDeadZone);
+    UART_OutString(" filter ");
+    UART_OutUDec(InputFilter);
+    OutCRLF();
+}
+
+void SetSleepTime(int argc, char *argv[]) {
+    uint32_t ms;
+    if (argc > 1) {
+        if (!Shell_ParseNumber(argv[1], &ms) || ms < 50 || ms > 5000) {
+            UART_OutString("sleep must be 50 to 5000 ms");
+            OutCRLF();
+            return;
+        }
+        SleepTime = ms;
+    }
+    UART_OutString("sleep ");
+    UART_OutUDec(SleepTime);
+    OutCRLF();
+}
+
+void SetTelemetry(int argc, char *argv[]) {
+    if (argc > 1) {
+        TelemetryOn = (strcmp(argv[1], "on") == 0);
+    }
+    UART_OutString(TelemetryOn ? "telemetry on" : "telemetry off");
+    OutCRLF();
+}
+
+void BarrierBench(int argc, char *argv[]) {
+    uint32_t n, max = 4;
+    unsigned long elapsed;
+    if (argc > 1 && (!Shell_ParseNumber(argv[1], &max) || max < 1)) {
+        UART_OutString("participants must be at least 1");
+        OutCRLF();
+        return;
+    }
+    for (n = 1; n <= max; n++) {
+        elapsed = BarrierRoundTrip(n, 5);
+        if (elapsed == 0) {
+            UART_OutString("no thread slot for ");
+            UART_OutUDec(n);
+            UART_OutString(" participants");
+            OutCRLF();
+            return;
+        }
+        UART_OutUDec(n);
+        UART_OutString(" participants ");
+        elapsed /= 8 * BARRIER_ROUNDS;  // 0.1 us per round trip
+        UART_OutUDec(elapsed / 10);
+        UART_OutChar('.');
+        UART_OutUDec(elapsed % 10);
+        UART_OutString(" us");
+        OutCRLF();
+    }
+}
+
+void FlushReplay(int argc, char *argv[]) {
+    Replay_Flush();
+    UART_OutString("replay frames dropped ");
+    UART_OutUDec(Replay_Dropped);
+    OutCRLF();
+    UART_OutString("replay steps out of line ");
+    UART_OutUDec(Replay_Slips);
+    OutCRLF();
+}
+
+#ifdef KERNEL_TRACE
+void DumpTrace(int argc, char *argv[]) {
+    TraceDump = 1;  // TelemetryThread owns the UART stream
+    UART_OutString("trace queued");
+    OutCRLF();
+}
+#endif
+
 void IdleThread(void) {
     while (1) OS_Suspend();
 }
@@ -1128,7 +1357,7 @@ int main(void) {
     uint32_t seedA, seedB;
     int i;
 #ifdef USE_NV_LEADERBOARD
-    uint32_t arr[NUM_HIGHSCORES + 1];
+    uint32_t arr[2 * NUM_HIGHSCORES + 1];
 #endif
 
     OS_Init();  // initialize, disable interrupts
@@ -1141,24 +1370,52 @@ int main(void) {
     EEPROMInit();
 #endif
     CrossHair_Init();
-    DataLost = 0;   // lost data between producer and consumer
-    MaxJitter = 0;  // in 1us units
-    Score = 0;
-    Life = DEFAULT_LIFE;
+    DataLost = 0;  // lost data between producer and consumer
+    GameState_Init(DEFAULT_LIFE, SMALL_XHAIR);
 
     // Grab readings from joystick
     BSP_Joystick_Input(&rawX, &rawY, &select);
     // Concatenate joystick readings
     seedA = (rawX << 16 | rawY);
     seedB = (rawY << 16 | rawX);
-    init_lfsrs(seedA, seedB);
     //********initialize communication channels
     JsFifo_Init();
+    Tel_Init();
+    Replay_Init(&SW1Action, &SW2Action);
+    AutoPlay_Init(&AutoPlayLook, &SW1Action, &SW2Action);
+    Hist_Init(&ClearHist, "lcdclear", TEL_ID_CLEARHIST);
+    Hist_Init(&WaveHist, "wave", TEL_ID_WAVEHIST);
+    Hist_Init(&StepHist, "step", TEL_ID_STEPHIST);
+    Hist_Init(&DrawHist, "draw", TEL_ID_DRAWHIST);
+    Hist_Init(&ConsumerHist, "consumer", TEL_ID_CONSUMERHIST);
+    Hist_Init(&DeferHist, "defer", TEL_ID_DEFERHIST);
+    Hist_Init(&ProducerHist, "producer", TEL_ID_PRODUCERHIST);
+    if (Replay_Start(&seedA, &seedB, &SleepTime, PERIOD / TIME_1MS)) {
+        Input_Init(CURSOR_BASE_SPEED);  // the log brought its own calibration and step time
+    }
+    init_lfsrs(seedA, seedB);
+    Shell_Init();
+    Shell_AddCommand("sema", &ShowSemas, "show semaphore values");
+    Shell_AddCommand("jitter", &ShowJitter, "jitter, run time, overruns and violations of periodic tasks");
+    Shell_AddCommand("reset", &ResetCounters, "clear jitter, frame time and data lost counters");
+    Shell_AddCommand("sleep", &SetSleepTime, "[ms] show or set the cube step time");
+    Shell_AddCommand("cubes", &SetCubes, "[n] cubes in the first wave, later waves 1 to n-1");
+    Shell_AddCommand("sampler", &ShowSampler, "latest mic, joystick and accelerometer samples");
+    Shell_AddCommand("cal", &Calibrate, "[save|reset] joystick min, center and max");
+    Shell_AddCommand("input", &SetInput, "[deadzone [filter]] joystick dead zone and IIR shift");
+    Shell_AddCommand("tel", &SetTelemetry, "[on|off] binary telemetry stream");
+    Shell_AddCommand("barrier", &BarrierBench, "[n] barrier round trip time for 1 to n threads");
+    Shell_AddCommand("auto", &SetAutoPlay, "[on|off] autoplay bot, games played and live threads");
+    Shell_AddCommand("hist", &ShowHists, "p50, p99 and max of the frame and phase timings");
+    Shell_AddCommand("replay", &FlushReplay, "send the recorded replay so far, show drops and step slips");
+#ifdef KERNEL_TRACE
+    Shell_AddCommand("trace", &DumpTrace, "stream the kernel trace ring as telemetry");
+#endif
     for (i = 0; i < NUM_HIGHSCORES; ++i) {
         highscores[i].score = -1;
     }
 #ifdef USE_NV_LEADERBOARD
-    EEPROMRead(arr, 0x0, 40);
+    EEPROMRead(arr, 0x0, sizeof(arr));
     if (arr[0] != MAGICBIT) {
         for (i = 0; i < NUM_HIGHSCORES; ++i) {
             highscores[i].score = -1;
@@ -1169,27 +1426,26 @@ int main(void) {
 #endif
 
     //*******attach background tasks***********
-    OS_AddSW1Task(&SW1Push, 4);
-    OS_AddSW2Task(&SW2Push, 4);
-    OS_AddPeriodicThread(&Producer, PERIOD, 3);  // 2 kHz real time sampling of PD3
+    Switch_Init();
+    SW1Button = Buttons_Add(&Switch_SW1);
+    SW2Button = Buttons_Add(&Switch_SW2);
+    Buttons_Init(4);  // Timer1A samples SW1 and SW2 every 5 ms
+    BSP_Joystick_AddTask(&ProducerIsr, PERIOD, 3);  // Timer0A triggered sampling of PD3 and PB5
 
-    OS_InitSemaphore(&MoveCubesSem, 0);
-    OS_InitSemaphore(&DoneMovingCubesSem, 0);
-    OS_InitSemaphore(&ThrottleSem, 0);
     OS_InitSemaphore(&CubeDrawing, 0);
-    OS_InitSemaphore(&NeedCubeRedraw, 0);
-    OS_InitSemaphore(&InfoSem, 1);
+    OS_FlagsInit(&GameFlags, 0);
     OS_InitSemaphore(&ResSem, 1);
-    OS_InitSemaphore(&DoneSem, 0);
-    OS_InitSemaphore(&reset_crosshair_sem, 1);
-    OS_InitSemaphore(&reset_speed_sem, 1);
-    OS_InitSemaphore(&freeze_sem, 1);
+    OS_BarrierInit(&GameOver, 4);
+    PowerUp_Init();
 
     NumCreated = 0;
     // create initial foreground threads
     NumCreated += OS_AddThread(&Consumer, 128, 1);
-    NumCreated += OS_AddThread(&InitAndSyncBlocks, 128, 1);
+    NumCreated += OS_AddThread(&UpdateCubes, 128, 1);
     NumCreated += OS_AddThread(&DrawCubes, 128, 3);
+    NumCreated += OS_AddThread(&ButtonThread, 128, 2);
+    NumCreated += OS_AddThread(&TelemetryThread, 128, 5);
+    NumCreated += OS_AddThread(&Shell_Thread, 128, 5);
     NumCreated += OS_AddThread(&IdleThread, 128, 6);
 
     OS_Launch(TIME_2MS);  // doesn't return, interrupts enabled in here
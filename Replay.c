@@ -0,0 +1,173 @@
+// Replay.c
+// Runs on LM4F120/TM4C123
+// Record and replay of game sessions, see Replay.h
+
+#include <stdint.h>
+#include "os.h"
+#include "Replay.h"
+#include "Telemetry.h"
+#include "Calibration.h"
+
+long StartCritical(void);   // previous I bit, disable interrupts
+void EndCritical(long sr);  // restore I bit to previous value
+
+static void (*ButtonTask[2])(void);
+unsigned long Replay_Dropped;
+unsigned long Replay_Slips;
+
+#if REPLAY_MODE == REPLAY_RECORD
+static void PutU32(uint8_t *pt, uint32_t value) {
+    pt[0] = value;
+    pt[1] = value >> 8;
+    pt[2] = value >> 16;
+    pt[3] = value >> 24;
+}
+
+static uint8_t Chunk[4 + REPLAY_CHUNK * REPLAY_RECORDSIZE];  // chunk number, then records
+static uint32_t ChunkCount;  // records in Chunk
+static uint32_t ChunkSeq;    // chunk number of the next frame
+
+// send the records in Chunk, called in a critical section
+static void SendChunk(void) {
+    PutU32(Chunk, ChunkSeq++);
+    if (!Tel_Replay(TEL_REPLAY_RECORDS, Chunk, 4 + ChunkCount * REPLAY_RECORDSIZE)) {
+        Replay_Dropped++;
+    }
+    ChunkCount = 0;
+}
+
+// append one record, sends the chunk when it is full
+// called from the Producer, ButtonThread and UpdateCubes, so in a critical section
+static void Record(uint32_t data) {
+    uint8_t *pt;
+    uint32_t now;
+    long sr;
+    sr = StartCritical();
+    now = OS_MsTime();
+    pt = &Chunk[4 + ChunkCount * REPLAY_RECORDSIZE];
+    pt[0] = now;
+    pt[1] = now >> 8;
+    PutU32(&pt[2], data);
+    ChunkCount++;
+    if (ChunkCount == REPLAY_CHUNK) {
+        SendChunk();
+    }
+    EndCritical(sr);
+}
+#endif
+
+#if REPLAY_MODE == REPLAY_PLAY
+static uint32_t PlayI;  // next record in ReplayLog
+static int Playing;
+static unsigned long LoggedSteps;  // step records played so far
+static unsigned long PlayedSteps;  // steps the replayed game made, written by UpdateCubes only
+#endif
+
+void Replay_Init(void (*button1)(void), void (*button2)(void)) {
+    ButtonTask[0] = button1;
+    ButtonTask[1] = button2;
+}
+
+int Replay_Start(uint32_t *seedA, uint32_t *seedB, unsigned long *stepMs,
+                 unsigned long sampleMs) {
+#if REPLAY_MODE == REPLAY_RECORD
+    uint8_t header[8 + 4 * 6 + 8];  // struct ReplayHeader, little endian
+    int i;
+    PutU32(&header[0], *seedA);
+    PutU32(&header[4], *seedB);
+    for (i = 0; i < 2; i++) {
+        PutU32(&header[8 + 12 * i], Cal_Axes[i].center);
+        PutU32(&header[12 + 12 * i], Cal_Axes[i].min);
+        PutU32(&header[16 + 12 * i], Cal_Axes[i].max);
+    }
+    PutU32(&header[32], *stepMs);
+    PutU32(&header[36], sampleMs);
+    if (!Tel_Replay(TEL_REPLAY_HEADER, header, sizeof(header))) {
+        Replay_Dropped++;
+    }
+    return 0;
+#elif REPLAY_MODE == REPLAY_PLAY
+    int i;
+    if (ReplayLogSize == 0) {
+        return 0;  // nothing to play, run live
+    }
+    *seedA = ReplayLogHeader.SeedA;
+    *seedB = ReplayLogHeader.SeedB;
+    for (i = 0; i < 2; i++) {
+        Cal_Axes[i].center = ReplayLogHeader.Cal[3 * i];
+        Cal_Axes[i].min = ReplayLogHeader.Cal[3 * i + 1];
+        Cal_Axes[i].max = ReplayLogHeader.Cal[3 * i + 2];
+    }
+    if (ReplayLogHeader.StepMs) {
+        *stepMs = ReplayLogHeader.StepMs;
+    }
+    PlayI = 0;
+    LoggedSteps = 0;
+    PlayedSteps = 0;
+    Replay_Slips = 0;
+    Playing = 1;
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+void Replay_Sample(uint16_t *x, uint16_t *y, uint8_t *select) {
+#if REPLAY_MODE == REPLAY_RECORD
+    Record((REPLAY_SAMPLE << 30) | ((uint32_t)(*select & 1) << 24) | ((uint32_t)(*y & 0xFFF) << 12) |
+           (*x & 0xFFF));
+#elif REPLAY_MODE == REPLAY_PLAY
+    uint32_t data;
+    while (Playing && PlayI < ReplayLogSize) {
+        data = ReplayLog[PlayI++];
+        if (REPLAY_KIND(data) == REPLAY_BUTTON) {
+            if ((data & 3) == 1 || (data & 3) == 2) {
+                ButtonTask[(data & 3) - 1]();
+            }
+        } else if (REPLAY_KIND(data) == REPLAY_STEP) {
+            LoggedSteps++;
+            if (PlayedSteps != LoggedSteps) {
+                Replay_Slips++;  // the cubes stepped between other samples than recorded
+            }
+        } else {
+            *x = data & 0xFFF;
+            *y = (data >> 12) & 0xFFF;
+            *select = (data >> 24) & 1;
+            return;
+        }
+    }
+    Playing = 0;  // end of the log, back to the live joystick and buttons
+#endif
+}
+
+int Replay_Button(int button) {
+#if REPLAY_MODE == REPLAY_RECORD
+    Record((REPLAY_BUTTON << 30) | (button & 3));
+    return 1;
+#elif REPLAY_MODE == REPLAY_PLAY
+    return !Playing;
+#else
+    return 1;
+#endif
+}
+
+void Replay_Step(void) {
+#if REPLAY_MODE == REPLAY_RECORD
+    Record((uint32_t)REPLAY_STEP << 30);
+#elif REPLAY_MODE == REPLAY_PLAY
+    if (Playing) {
+        PlayedSteps++;
+    }
+#endif
+}
+
+void Replay_Flush(void) {
+#if REPLAY_MODE == REPLAY_RECORD
+    long sr;
+    sr = StartCritical();
+    if (ChunkCount) {
+        SendChunk();
+    }
+    EndCritical(sr);
+#endif
+}
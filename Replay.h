@@ -0,0 +1,109 @@
+// Replay.h
+// Runs on LM4F120/TM4C123
+// Record and replay of game sessions.
+// A session is decided by the LFSR seeds, the joystick calibration at
+// boot, every joystick sample in order, and the button presses between
+// them.  REPLAY_RECORD streams all of that as TEL_REPLAY telemetry
+// frames; tools/replay.py turns a capture into ReplayLog.c, and
+// REPLAY_PLAY feeds that log back in place of the ADC and the buttons,
+// one logged sample per Producer tick.
+// The inputs replay exactly, the game only as far as the cubes step
+// between the same samples: UpdateCubes steps on its own period, and
+// where a step falls against the samples depends on the thread
+// interleaving.  The header carries the step time and the sample
+// period, and playback restores the step time; the log also marks each
+// cube step, and Replay_Slips counts the logged steps the replayed game
+// was not level with, so a diverged run can be told from a faithful one.
+//
+// Record frames start with a 4-byte chunk number, 0 for the first after
+// the header and one more for each frame sent or dropped, so a capture
+// with a gap can be told apart from a whole one.  Then come up to
+// REPLAY_CHUNK log records of 6 bytes, little endian:
+//   time(2)  low 16 bits of OS_MsTime, informational only
+//   data(4)  bits 31-30 kind
+//            REPLAY_SAMPLE: x in bits 11-0, y in bits 23-12, select in bit 24
+//            REPLAY_BUTTON: button number (1 or 2) in bits 1-0
+//            REPLAY_STEP: nothing, the cubes stepped
+// A button record applies before the sample that follows it, a step
+// record tells the game stepped before it.
+
+#ifndef __REPLAY_H__
+#define __REPLAY_H__
+
+#include <stdint.h>
+
+#define REPLAY_OFF 0
+#define REPLAY_RECORD 1  // needs telemetry on, see the tel shell command
+#define REPLAY_PLAY 2    // needs a log in ReplayLog.c
+#define REPLAY_MODE REPLAY_OFF
+
+#define REPLAY_SAMPLE 0
+#define REPLAY_BUTTON 1
+#define REPLAY_STEP 2
+#define REPLAY_KIND(data) ((data) >> 30)
+#define REPLAY_RECORDSIZE 6
+#define REPLAY_CHUNK 10  // records per telemetry frame, after the chunk number
+
+// what a session starts from, sent once as the first TEL_REPLAY frame
+struct ReplayHeader {
+    uint32_t SeedA;
+    uint32_t SeedB;
+    int32_t Cal[6];    // center, min, max of X then of Y
+    uint32_t StepMs;   // SleepTime at the start, ms between cube steps
+    uint32_t SampleMs; // joystick sample period, informational only
+};
+
+// TEL_REPLAY frames telemetry had no room for, the log has a gap
+extern unsigned long Replay_Dropped;
+
+// logged cube steps the replayed game had made a different number of
+// steps at, 0 while the replay follows the recorded game
+extern unsigned long Replay_Slips;
+
+// the log REPLAY_PLAY plays back, written by tools/replay.py
+extern const struct ReplayHeader ReplayLogHeader;
+extern const uint32_t ReplayLog[];  // data fields only
+extern const uint32_t ReplayLogSize;
+
+// ******** Replay_Init ************
+// select what a replayed button press does
+// input:  actions of button 1 and button 2, without debouncing
+// output: none
+void Replay_Init(void (*button1)(void), void (*button2)(void));
+
+// ******** Replay_Start ************
+// record the session's seeds, calibration and timing, or load them
+// from the log, call after Cal_Init and before the seeds are used
+// input:  pointers to the two LFSR seeds and the cube step time in ms,
+//         joystick sample period in ms
+// output: 1 if the seeds, calibration and step time were replaced from the log
+int Replay_Start(uint32_t *seedA, uint32_t *seedB, unsigned long *stepMs,
+                 unsigned long sampleMs);
+
+// ******** Replay_Sample ************
+// record a joystick sample, or replace it with the next logged one
+// and run the button presses logged before it, called from Producer
+// input:  pointers to the sample
+// output: none
+void Replay_Sample(uint16_t *x, uint16_t *y, uint8_t *select);
+
+// ******** Replay_Button ************
+// record a debounced button press
+// input:  button number, 1 or 2
+// output: 1 if the press should be acted on, 0 while a log is playing
+int Replay_Button(int button);
+
+// ******** Replay_Step ************
+// record a cube step, or check it against the log, called from UpdateCubes
+// input:  none
+// output: none
+void Replay_Step(void);
+
+// ******** Replay_Flush ************
+// send the records waiting for a full chunk, called at game over and
+// from the replay shell command so the end of a session is not lost
+// input:  none
+// output: none
+void Replay_Flush(void);
+
+#endif
@@ -0,0 +1,12 @@
+// ReplayLog.c
+// Runs on LM4F120/TM4C123
+// Session log played back when REPLAY_MODE is REPLAY_PLAY, see Replay.h.
+// Replace this file with the output of tools/replay.py; the empty log
+// below makes REPLAY_PLAY run live.
+
+#include <stdint.h>
+#include "Replay.h"
+
+const struct ReplayHeader ReplayLogHeader = {0, 0, {0, 0, 0, 0, 0, 0}, 0, 0};
+const uint32_t ReplayLog[] = {0};
+const uint32_t ReplayLogSize = 0;
@@ -0,0 +1,128 @@
+// Sampler.c
+// Runs on LM4F120/TM4C123
+// Continuous six channel ADC1 sampling into a uDMA ring, see Sampler.h
+
+#include <stdint.h>
+#include "tm4c123gh6pm.h"
+#include "os.h"
+#include "DMA.h"
+#include "Sampler.h"
+
+long StartCritical(void);   // previous I bit, disable interrupts
+void EndCritical(long sr);  // restore I bit to previous value
+
+#define BLOCKSIZE (SAMPLER_BLOCKFRAMES * SAMPLER_CHANNELS)  // 16-bit items, at most 1024
+#define CHANNEL (1 << DMA_CH_ADC1SS0)
+
+static uint16_t Ring[SAMPLER_BLOCKS * BLOCKSIZE];
+static uint32_t volatile BlocksDone;  // blocks completely written by the uDMA
+static uint32_t volatile ActiveAlt;   // structure filling block BlocksDone
+static uint32_t NextBlock;            // next block to hand to the uDMA
+unsigned long SamplerOverflow;        // ADC1 FIFO overflows, uDMA fell behind
+
+// point one control structure at the next free block
+void static LoadBlock(uint32_t alt) {
+    DMA_SetTransfer(DMA_CH_ADC1SS0, alt, &ADC1_SSFIFO0_R,
+                    &Ring[(NextBlock % SAMPLER_BLOCKS) * BLOCKSIZE + BLOCKSIZE - 1],
+                    DMA_DSTINC_16 | DMA_DSTSIZE_16 | DMA_SRCINC_NONE | DMA_SRCSIZE_16 | DMA_ARB_2 |
+                        DMA_XFERSIZE(BLOCKSIZE) | DMA_MODE_PINGPONG);
+    NextBlock++;
+}
+
+void Sampler_Init(uint32_t priority) {
+    long sr;
+    sr = StartCritical();
+    SYSCTL_RCGCADC_R |= 0x00000002;   // 1) activate ADC1
+    SYSCTL_RCGCGPIO_R |= 0x0000001A;  //    and Ports E, D, and B
+    while ((SYSCTL_PRGPIO_R & 0x1A) != 0x1A) {
+    };  // allow time for clocks to stabilize
+    // 2) PE5, PB5, PD3-0 are analog inputs
+    GPIO_PORTE_DIR_R &= ~0x20;
+    GPIO_PORTE_AFSEL_R |= 0x20;
+    GPIO_PORTE_DEN_R &= ~0x20;
+    GPIO_PORTE_AMSEL_R |= 0x20;
+    GPIO_PORTB_DIR_R &= ~0x20;
+    GPIO_PORTB_AFSEL_R |= 0x20;
+    GPIO_PORTB_DEN_R &= ~0x20;
+    GPIO_PORTB_AMSEL_R |= 0x20;
+    GPIO_PORTD_DIR_R &= ~0x0F;
+    GPIO_PORTD_AFSEL_R |= 0x0F;
+    GPIO_PORTD_DEN_R &= ~0x0F;
+    GPIO_PORTD_AMSEL_R |= 0x0F;
+    while ((SYSCTL_PRADC_R & 0x02) == 0) {
+    };                                      // allow time for clock to stabilize
+    ADC1_PC_R = (ADC1_PC_R & ~0xF) | 0x1;  // 3) 125K samples/sec
+    ADC1_SAC_R = 0x4;                       // 4) average 16 conversions per sample
+    ADC1_ACTSS_R &= ~0x0001;                // 5) disable sample sequencer 0
+    ADC1_EMUX_R |= 0x000F;                  // 6) seq0 is always (continuous) trigger
+    ADC1_SSMUX0_R = 0x005674B8;             // 7) AIN8, 11, 4, 7, 6, 5 in SAMPLER_ order
+    // 8) a uDMA request every two samples (IE1, IE3, IE5) to match the
+    //    arbitration size, END5 closes the frame
+    ADC1_SSCTL0_R = 0x00604040;
+    ADC1_IM_R &= ~0x0001;   // 9) no sequencer interrupt, the uDMA interrupts
+    ADC1_OSTAT_R = 0x0001;  //    clear any overflow
+
+    // 10) uDMA channel 24 ping-pong into the ring
+    DMA_Init();
+    BlocksDone = ActiveAlt = NextBlock = 0;
+    UDMA_ENACLR_R = CHANNEL;
+    UDMA_CHMAP3_R = (UDMA_CHMAP3_R & ~0x0000000F) | 0x00000001;  // encoding 1 is ADC1 SS0
+    UDMA_PRIOCLR_R = CHANNEL;
+    UDMA_ALTCLR_R = CHANNEL;
+    UDMA_USEBURSTSET_R = CHANNEL;  // the ADC only makes burst requests
+    UDMA_REQMASKCLR_R = CHANNEL;
+    LoadBlock(0);
+    LoadBlock(1);
+    UDMA_ENASET_R = CHANNEL;
+
+    // 11) priority shifted to bits 7-5 for ADC1 SS0 (interrupt 48)
+    NVIC_PRI12_R = (NVIC_PRI12_R & 0xFFFFFF00) | (priority << 5);
+    NVIC_EN1_R = 1 << (48 - 32);  // 12) enable interrupt 48 in NVIC
+    ADC1_ACTSS_R |= 0x0001;       // 13) enable sample sequencer 0, starts sampling
+    EndCritical(sr);
+}
+
+// the uDMA filled a block
+void ADC1Seq0_Handler(void) {
+    if (UDMA_CHIS_R & CHANNEL) {
+        UDMA_CHIS_R = CHANNEL;  // acknowledge
+        while (DMA_Remaining(DMA_CH_ADC1SS0, ActiveAlt) == 0) {
+            BlocksDone++;
+            LoadBlock(ActiveAlt);  // reuse it two blocks ahead
+            ActiveAlt ^= 1;
+        }
+        UDMA_ENASET_R = CHANNEL;  // in case both structures had run out
+    }
+    if (ADC1_OSTAT_R & 0x0001) {
+        ADC1_OSTAT_R = 0x0001;  // acknowledge overflow
+        SamplerOverflow++;
+    }
+}
+
+uint32_t Sampler_Blocks(void) { return BlocksDone; }
+
+int Sampler_Valid(uint32_t n) {
+    // the uDMA owns blocks BlocksDone and BlocksDone+1
+    return (BlocksDone - n - 1) < (SAMPLER_BLOCKS - 2);
+}
+
+const uint16_t *Sampler_Block(uint32_t n) {
+    if (!Sampler_Valid(n)) {
+        return 0;  // not written yet or already being overwritten
+    }
+    return &Ring[(n % SAMPLER_BLOCKS) * BLOCKSIZE];
+}
+
+uint16_t Sampler_Latest(uint32_t channel) {
+    const uint16_t *block;
+    uint32_t n;
+    n = BlocksDone;
+    if (n == 0) {
+        return 0;
+    }
+    block = Sampler_Block(n - 1);
+    if (block == 0) {
+        return 0;  // lapped while reading BlocksDone
+    }
+    return SAMPLER_SAMPLE(block, SAMPLER_BLOCKFRAMES - 1, channel);
+}
@@ -0,0 +1,72 @@
+// Sampler.h
+// Runs on LM4F120/TM4C123
+// Continuous sampling of the six BoosterPack MKII analog inputs.
+// ADC1 sample sequencer 0 converts all six channels back to back,
+// forever, and the uDMA copies each sweep (a frame) into a RAM ring
+// without any CPU work.  The ring is split into blocks of
+// SAMPLER_BLOCKFRAMES frames; consumers read whole blocks in place.
+//
+// ADC0 sequencer 1 keeps its Timer0A trigger for the joystick.  The
+// timer trigger on this part is shared by both ADCs (any timer with
+// TnOTE set starts every sequencer set to timer trigger), so the
+// sampler uses the "always" trigger and is paced by the ADC1 sample
+// rate and hardware averaging instead of a second timer.
+
+#ifndef __SAMPLER_H__
+#define __SAMPLER_H__
+
+#include <stdint.h>
+
+// channel order inside a frame
+#define SAMPLER_MIC 0   // microphone, J1.6/PE5/AIN8
+#define SAMPLER_JOYX 1  // joystick X, J1.2/PB5/AIN11
+#define SAMPLER_JOYY 2  // joystick Y, J3.26/PD3/AIN4
+#define SAMPLER_ACCX 3  // accelerometer X, J3.23/PD0/AIN7
+#define SAMPLER_ACCY 4  // accelerometer Y, J3.24/PD1/AIN6
+#define SAMPLER_ACCZ 5  // accelerometer Z, J3.25/PD2/AIN5
+#define SAMPLER_CHANNELS 6
+
+#define SAMPLER_BLOCKFRAMES 32  // frames per uDMA transfer
+#define SAMPLER_BLOCKS 4        // blocks in the ring, power of 2
+// 125k conversions/s, 16x hardware averaging, 6 channels
+#define SAMPLER_RATE 1302       // frames per second
+
+// ADC1 FIFO overflows, counted once per block if the uDMA fell behind
+extern unsigned long SamplerOverflow;
+
+// sample of channel ch in frame f of a block returned by Sampler_Block
+#define SAMPLER_SAMPLE(block, f, ch) ((block)[(f)*SAMPLER_CHANNELS + (ch)])
+
+// ******** Sampler_Init ************
+// start continuous sampling on ADC1 sequencer 0
+// input:  priority of the ADC1 SS0 interrupt, which runs once per block
+// output: none
+void Sampler_Init(uint32_t priority);
+
+// ******** Sampler_Blocks ************
+// number of blocks completed since Sampler_Init
+// the newest complete block is Sampler_Blocks() - 1
+// input:  none
+// output: block count, wraps at 2^32
+uint32_t Sampler_Blocks(void);
+
+// ******** Sampler_Block ************
+// zero copy access to a complete block of interleaved frames
+// the block stays intact for about SAMPLER_BLOCKS-2 block times; check
+// Sampler_Valid after using it to know the data was not overwritten
+// input:  block number from Sampler_Blocks
+// output: pointer to SAMPLER_BLOCKFRAMES frames, 0 if not available
+const uint16_t *Sampler_Block(uint32_t n);
+
+// ******** Sampler_Valid ************
+// input:  block number from Sampler_Blocks
+// output: 1 if the uDMA has not started overwriting the block yet
+int Sampler_Valid(uint32_t n);
+
+// ******** Sampler_Latest ************
+// last sample of one channel from the newest complete block
+// input:  SAMPLER_ channel
+// output: 12-bit sample, 0 before the first block completes
+uint16_t Sampler_Latest(uint32_t channel);
+
+#endif
@@ -0,0 +1,152 @@
+// Shell.c
+// Runs on LM4F120/TM4C123
+// Line oriented command shell on UART0, see Shell.h
+
+#include <stdint.h>
+#include <string.h>
+#include "os.h"
+#include "UART.h"
+#include "Shell.h"
+
+struct ShellCommand {
+    char *name;
+    ShellHandler handler;
+    char *help;
+};
+
+static struct ShellCommand Commands[SHELL_MAXCOMMANDS];
+static uint32_t NumCommands;
+static char Line[SHELL_LINESIZE + 1];
+
+int Shell_AddCommand(char *name, ShellHandler handler, char *help) {
+    if (NumCommands == SHELL_MAXCOMMANDS) {
+        return 0;  // no room in the table
+    }
+    Commands[NumCommands].name = name;
+    Commands[NumCommands].handler = handler;
+    Commands[NumCommands].help = help;
+    NumCommands++;
+    return 1;
+}
+
+int Shell_ParseNumber(char *pt, uint32_t *value) {
+    uint32_t number = 0, base = 10, digit;
+    if (pt[0] == '0' && (pt[1] == 'x' || pt[1] == 'X')) {
+        base = 16;
+        pt += 2;
+    }
+    if (*pt == 0) return 0;
+    while (*pt) {
+        if ((*pt >= '0') && (*pt <= '9')) {
+            digit = *pt - '0';
+        } else if ((*pt >= 'a') && (*pt <= 'f')) {
+            digit = *pt - 'a' + 0xA;
+        } else if ((*pt >= 'A') && (*pt <= 'F')) {
+            digit = *pt - 'A' + 0xA;
+        } else {
+            return 0;
+        }
+        if (digit >= base) return 0;
+        number = number * base + digit;
+        pt++;
+    }
+    *value = number;
+    return 1;
+}
+
+// Built in commands ------------------------------------------------------------------------
+
+static void Help(int argc, char *argv[]) {
+    uint32_t i;
+    for (i = 0; i < NumCommands; i++) {
+        UART_OutString(Commands[i].name);
+        UART_OutString(" - ");
+        UART_OutString(Commands[i].help);
+        OutCRLF();
+    }
+}
+
+static void Threads(int argc, char *argv[]) {
+    uint32_t slot, id, execCount, waitTime, period, jobs, misses;
+    UART_OutString("id exec wait(ms) period(ms) jobs misses");
+    OutCRLF();
+    for (slot = 0; slot < NUMTHREADS; slot++) {
+        if (OS_ThreadStats(slot, &id, &execCount, &waitTime) &&
+            OS_ThreadDeadlines(slot, &period, &jobs, &misses)) {
+            UART_OutUDec(id);
+            UART_OutChar(SP);
+            UART_OutUDec(execCount);
+            UART_OutChar(SP);
+            UART_OutUDec(waitTime);
+            if (period) {  // only periodic threads have deadlines
+                UART_OutChar(SP);
+                UART_OutUDec(period);
+                UART_OutChar(SP);
+                UART_OutUDec(jobs);
+                UART_OutChar(SP);
+                UART_OutUDec(misses);
+            }
+            OutCRLF();
+        }
+    }
+}
+
+static void Slice(int argc, char *argv[]) {
+    uint32_t slice;
+    if (argc > 1) {
+        // SysTick is 24 bits, anything under 1000 cycles just thrashes
+        if (!Shell_ParseNumber(argv[1], &slice) || slice < 1000 || slice > 0x01000000) {
+            UART_OutString("slice must be 1000 to 16777216 cycles");
+            OutCRLF();
+            return;
+        }
+        OS_SetTimeSlice(slice);
+    }
+    UART_OutString("slice ");
+    UART_OutUDec(OS_TimeSlice());
+    OutCRLF();
+}
+
+void Shell_Init(void) {
+    NumCommands = 0;
+    Shell_AddCommand("help", &Help, "list commands");
+    Shell_AddCommand("threads", &Threads, "list threads");
+    Shell_AddCommand("slice", &Slice, "[cycles] show or set the time slice");
+}
+
+// split Line in place on spaces
+static int Tokenize(char *argv[]) {
+    int argc = 0;
+    char *pt = Line;
+    while (*pt && argc < SHELL_MAXARGS) {
+        while (*pt == SP) *pt++ = 0;
+        if (*pt == 0) break;
+        argv[argc++] = pt;
+        while (*pt && *pt != SP) pt++;
+    }
+    *pt = 0;  // ignore anything past the last argument
+    return argc;
+}
+
+void Shell_Thread(void) {
+    char *argv[SHELL_MAXARGS];
+    int argc;
+    uint32_t i;
+    while (1) {
+        UART_OutString("> ");
+        UART_InString(Line, SHELL_LINESIZE);
+        OutCRLF();
+        argc = Tokenize(argv);
+        if (argc == 0) continue;
+        for (i = 0; i < NumCommands; i++) {
+            if (strcmp(argv[0], Commands[i].name) == 0) {
+                Commands[i].handler(argc, argv);
+                break;
+            }
+        }
+        if (i == NumCommands) {
+            UART_OutString("unknown command, try help");
+            OutCRLF();
+        }
+    }
+}
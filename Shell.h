@@ -0,0 +1,48 @@
+// Shell.h
+// Runs on LM4F120/TM4C123
+// Line oriented command shell on UART0 for inspecting and tuning
+// the running system.  Commands live in a fixed table, so modules
+// add their own commands with Shell_AddCommand before OS_Launch.
+// The shell runs as a low priority foreground thread and only waits
+// on the UART receive FIFO, it never allocates memory or touches the
+// background (ISR) data paths except through the command handlers.
+
+#ifndef __SHELL_H__
+#define __SHELL_H__
+
+#include <stdint.h>
+
+#define SHELL_MAXCOMMANDS 20  // size of the command table
+#define SHELL_MAXARGS 4       // command name plus three arguments
+#define SHELL_LINESIZE 40     // longest command line
+
+// command handler, argv[0] is the command name
+typedef void (*ShellHandler)(int argc, char *argv[]);
+
+// ******** Shell_Init ************
+// clear the command table and add the built in commands
+// (help, threads, slice)
+// input:  none
+// output: none
+void Shell_Init(void);
+
+// ******** Shell_AddCommand ************
+// add a command to the shell
+// input:  command name, handler, one line of help text
+//         name and help must stay valid, they are not copied
+// output: 1 if successful, 0 if the table is full
+int Shell_AddCommand(char *name, ShellHandler handler, char *help);
+
+// ******** Shell_ParseNumber ************
+// convert a decimal or 0x prefixed hexadecimal argument
+// input:  NULL terminated string, pointer to store the value
+// output: 1 if the whole string was a number, 0 otherwise
+int Shell_ParseNumber(char *pt, uint32_t *value);
+
+// ******** Shell_Thread ************
+// foreground thread, reads and executes one line at a time
+// input:  none
+// output: none
+void Shell_Thread(void);
+
+#endif
@@ -0,0 +1,30 @@
+// Switch.c
+// Runs on LM4F120/TM4C123
+// SW1 (PD6) and SW2 (PD7) on the BoosterPack, see Switch.h
+
+#include <stdint.h>
+#include "Switch.h"
+#include "tm4c123gh6pm.h"
+
+#define BUTTON1 (*((volatile uint32_t *)0x40007100)) /* PD6 */
+#define BUTTON2 (*((volatile uint32_t *)0x40007200)) /* PD7 */
+
+void Switch_Init(void) {
+    SYSCTL_RCGCGPIO_R |= 0x00000008;  // 1) activate clock for Port D
+    while ((SYSCTL_PRGPIO_R & 0x08) == 0) {
+    };                               // allow time for clock to stabilize
+    GPIO_PORTD_LOCK_R = 0x4C4F434B;  // 2) unlock GPIO Port D, PD7 is locked
+    GPIO_PORTD_CR_R |= 0xC0;         // allow changes to PD7-6
+    GPIO_PORTD_AMSEL_R &= ~0xC0;     // 3) disable analog on PD7-6
+                                     // 4) configure PD7-6 as GPIO
+    GPIO_PORTD_PCTL_R = (GPIO_PORTD_PCTL_R & 0x00FFFFFF) + 0x00000000;
+    GPIO_PORTD_DIR_R &= ~0xC0;    // 5) make PD7-6 inputs
+    GPIO_PORTD_AFSEL_R &= ~0xC0;  // 6) disable alt funct on PD7-6
+    GPIO_PORTD_DEN_R |= 0xC0;     // 7) enable digital I/O on PD7-6
+    GPIO_PORTD_PUR_R |= 0xC0;     //     enable weak pull-ups on PD7-6
+    GPIO_PORTD_IM_R &= ~0xC0;     //     no interrupts, Buttons.c polls them
+}
+
+int Switch_SW1(void) { return BUTTON1 == 0; }
+
+int Switch_SW2(void) { return BUTTON2 == 0; }
@@ -0,0 +1,25 @@
+// Switch.h
+// Runs on LM4F120/TM4C123
+// SW1 (PD6) and SW2 (PD7) on the BoosterPack, polled, no interrupts.
+// Both are active low with the internal pull-ups; Buttons.c debounces them.
+
+#ifndef __SWITCH_H__
+#define __SWITCH_H__
+
+// ******** Switch_Init ************
+// make PD6 and PD7 inputs with pull-ups
+// input:  none
+// output: none
+void Switch_Init(void);
+
+// ******** Switch_SW1 ************
+// input:  none
+// output: 1 while SW1 is held, not debounced
+int Switch_SW1(void);
+
+// ******** Switch_SW2 ************
+// input:  none
+// output: 1 while SW2 is held, not debounced
+int Switch_SW2(void);
+
+#endif
@@ -0,0 +1,193 @@
+// Telemetry.c
+// Runs on LM4F120/TM4C123
+// Compact binary telemetry over UART0, see Telemetry.h for the frame format.
+// Tel_Send computes the CRC over the header and payload, then COBS
+// encodes the frame straight into an index FIFO in one critical section,
+// so ISRs and threads can both emit records without blocking and no
+// frame buffer sits on the caller's stack.  A frame that does not fit
+// is dropped whole.
+
+#include <stdint.h>
+#include "os.h"
+#include "UART.h"
+#include "Telemetry.h"
+#include "driverlib/sw_crc.h"
+
+long StartCritical(void);   // previous I bit, disable interrupts
+void EndCritical(long sr);  // restore I bit to previous value
+
+#define TELRINGSIZE 1024  // must be a power of 2
+#define TELHEADER 6       // type, id, time
+
+static unsigned long volatile Tel_PutI;  // put next
+static unsigned long volatile Tel_GetI;  // get next
+static uint8_t Tel_Ring[TELRINGSIZE];
+// payload of the multi-record frames, shared since only the telemetry
+// thread sends them and 66 bytes is too much for a 400 byte stack
+static uint8_t Tel_Payload[TEL_MAXPAYLOAD];
+unsigned long Tel_Dropped;
+
+void Tel_Init(void) {
+    long sr;
+    sr = StartCritical();
+    Tel_PutI = Tel_GetI = 0;  // Empty
+    Tel_Dropped = 0;
+    EndCritical(sr);
+}
+
+static void PutU32(uint8_t *pt, uint32_t value) {
+    pt[0] = value;
+    pt[1] = value >> 8;
+    pt[2] = value >> 16;
+    pt[3] = value >> 24;
+}
+
+// Consistent overhead byte stuffing straight into the ring, which removes
+// every 0x00 from the frame; CobsPut appends one frame byte, CobsStart
+// and CobsEnd open and close the frame, call all three with interrupts
+// disabled.  A frame of len bytes takes len + 1 + len / 254 ring bytes.
+static unsigned long CobsCodeI;  // ring index of the current group's code byte
+static uint8_t CobsCode;         // bytes in the current group plus one
+
+static void CobsStart(void) {
+    CobsCodeI = Tel_PutI++;
+    CobsCode = 1;
+}
+
+static void CobsPut(uint8_t byte) {
+    if (byte == 0) {
+        Tel_Ring[CobsCodeI & (TELRINGSIZE - 1)] = CobsCode;
+        CobsStart();
+        return;
+    }
+    Tel_Ring[Tel_PutI & (TELRINGSIZE - 1)] = byte;
+    Tel_PutI++;
+    if (++CobsCode == 0xFF) {  // longest possible group
+        Tel_Ring[CobsCodeI & (TELRINGSIZE - 1)] = CobsCode;
+        CobsStart();
+    }
+}
+
+static void CobsEnd(void) {
+    Tel_Ring[CobsCodeI & (TELRINGSIZE - 1)] = CobsCode;
+    Tel_Ring[Tel_PutI & (TELRINGSIZE - 1)] = 0;  // frame delimiter
+    Tel_PutI++;
+}
+
+// build, encode and queue one frame
+// only the header is on the stack, the frame is encoded into the ring
+static int Tel_Send(uint8_t type, uint8_t id, const uint8_t *payload, uint16_t len) {
+    uint8_t header[TELHEADER];
+    uint16_t crc, n, i;
+    long sr;
+    header[0] = type;
+    header[1] = id;
+    PutU32(&header[2], OS_MsTime());
+    crc = Crc16(0, header, TELHEADER);
+    crc = Crc16(crc, payload, len);
+    n = TELHEADER + len + 2;  // raw frame length
+
+    sr = StartCritical();
+    if (TELRINGSIZE - (Tel_PutI - Tel_GetI) < (unsigned long)n + 2 + n / 254) {
+        Tel_Dropped++;
+        EndCritical(sr);
+        return 0;  // Failed, not enough room for the whole frame
+    }
+    CobsStart();
+    for (i = 0; i < TELHEADER; i++) {
+        CobsPut(header[i]);
+    }
+    for (i = 0; i < len; i++) {
+        CobsPut(payload[i]);
+    }
+    CobsPut(crc);
+    CobsPut(crc >> 8);
+    CobsEnd();
+    EndCritical(sr);
+    return 1;
+}
+
+int Tel_Counter(uint8_t id, uint32_t value) {
+    uint8_t payload[4];
+    PutU32(payload, value);
+    return Tel_Send(TEL_COUNTER, id, payload, 4);
+}
+
+int Tel_Event(uint8_t id, uint32_t arg) {
+    uint8_t payload[4];
+    PutU32(payload, arg);
+    return Tel_Send(TEL_EVENT, id, payload, 4);
+}
+
+int Tel_Histogram(uint8_t id, const unsigned long *bins, uint16_t size) {
+    uint8_t *payload = Tel_Payload;
+    uint16_t first, count, i;
+    int frames = 0;
+    if (size > 255) size = 255;
+    for (first = 0; first < size; first += count) {
+        count = size - first;
+        if (count > TEL_HISTCHUNK) count = TEL_HISTCHUNK;
+        payload[0] = first;
+        payload[1] = count;
+        for (i = 0; i < count; i++) {
+            PutU32(&payload[2 + 4 * i], bins[first + i]);
+        }
+        frames += Tel_Send(TEL_HISTOGRAM, id, payload, 2 + 4 * count);
+    }
+    return frames;
+}
+
+int Tel_Thread(uint8_t id, uint32_t execCount, uint32_t waitTime) {
+    uint8_t payload[8];
+    PutU32(&payload[0], execCount);
+    PutU32(&payload[4], waitTime);
+    return Tel_Send(TEL_THREAD, id, payload, 8);
+}
+
+int Tel_Periodic(uint8_t slot, const PeriodicStatsType *stats) {
+    uint8_t payload[16];
+    PutU32(&payload[0], stats->Releases);
+    PutU32(&payload[4], stats->MaxJitter);
+    PutU32(&payload[8], stats->MaxExec);
+    PutU32(&payload[12], stats->Overruns);
+    return Tel_Send(TEL_PERIODIC, slot, payload, 16);
+}
+
+int Tel_Violations(const struct PeriodicViolation *recs, int count) {
+    uint8_t *payload = Tel_Payload;
+    int i;
+    if (count > TEL_VIOLATIONCHUNK) count = TEL_VIOLATIONCHUNK;
+    for (i = 0; i < count; i++) {
+        PutU32(&payload[14 * i], recs[i].Seq);
+        PutU32(&payload[14 * i + 4], recs[i].Start);
+        PutU32(&payload[14 * i + 8], recs[i].Finish);
+        payload[14 * i + 12] = recs[i].Slot;
+        payload[14 * i + 13] = recs[i].Kind;
+    }
+    return Tel_Send(TEL_VIOLATION, 0, payload, 14 * count);
+}
+
+int Tel_Trace(const struct TraceRecord *recs, int count) {
+    uint8_t *payload = Tel_Payload;
+    int i;
+    if (count > TEL_TRACECHUNK) count = TEL_TRACECHUNK;
+    for (i = 0; i < count; i++) {
+        PutU32(&payload[10 * i], recs[i].time);
+        payload[10 * i + 4] = recs[i].type;
+        payload[10 * i + 5] = recs[i].thread;
+        PutU32(&payload[10 * i + 6], recs[i].arg);
+    }
+    return Tel_Send(TEL_TRACE, 0, payload, 10 * count);
+}
+
+int Tel_Replay(uint8_t id, const uint8_t *payload, uint16_t len) {
+    if (len > TEL_MAXPAYLOAD) len = TEL_MAXPAYLOAD;
+    return Tel_Send(TEL_REPLAY, id, payload, len);
+}
+
+void Tel_Drain(void) {
+    while (Tel_GetI != Tel_PutI) {
+        UART_OutChar(Tel_Ring[Tel_GetI & (TELRINGSIZE - 1)]);
+        Tel_GetI++;
+    }
+}
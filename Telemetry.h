@@ -0,0 +1,135 @@
+// Telemetry.h
+// Runs on LM4F120/TM4C123
+// Compact binary telemetry over UART0.
+// Each record is a small typed frame:
+//   type(1) id(1) time(4, OS_MsTime) payload(0-66) crc(2, CRC-16 from sw_crc.c)
+// The frame is COBS encoded and terminated with a 0x00 byte, so a host
+// can resynchronize on any zero byte after a dropped or corrupted frame.
+// All multi-byte fields are little endian.
+// Records are queued into a RAM ring by the Tel_ functions, which never
+// block and may be called from ISRs; Tel_Drain moves the ring to UART0
+// and is called from a low priority foreground thread.
+// The frames share UART0 with the shell (Shell.h), which prints plain
+// text with UART_OutString.  Nothing orders the two, so a shell reply
+// can land between or inside frames: the decoder drops the frames it
+// breaks, and the text is hard to read among the binary bytes.  Turn
+// the stream off with 'tel off' before using the shell interactively.
+// tools/teldecode.py converts a captured stream into CSV.
+
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#include <stdint.h>
+#include "os.h"
+
+// record types
+#define TEL_COUNTER 1    // payload: value(4)
+#define TEL_HISTOGRAM 2  // payload: first bin(1) bin count(1) bins(4 each)
+#define TEL_EVENT 3      // payload: arg(4)
+#define TEL_THREAD 4     // payload: exec count(4) wait time(4), id is the thread id
+#define TEL_TRACE 5      // payload: kernel trace records, time(4) type(1) thread(1) arg(4) each
+#define TEL_REPLAY 6     // payload: session log, see Replay.h
+#define TEL_PERIODIC 7   // payload: releases(4) max jitter in 0.1 us(4) max exec(4) overruns(4),
+                         // id is the OS periodic slot
+#define TEL_VIOLATION 8  // payload: periodic violation records,
+                         // seq(4) start(4) finish(4) slot(1) kind(1) each
+
+// record ids, shared with tools/teldecode.py
+#define TEL_ID_DATALOST 1
+#define TEL_ID_MAXJITTER 2  // 2, 3 and 9 were the Producer's own timing, now TEL_PERIODIC
+#define TEL_ID_JITTER 3
+#define TEL_ID_SCORE 4
+#define TEL_ID_LIFE 5
+#define TEL_ID_CONSUMERCOUNT 6
+#define TEL_ID_UPDATEWORK 7
+#define TEL_ID_TELDROPPED 8
+#define TEL_ID_MAXISRTIME 9
+#define TEL_ID_SEMAOPS 10  // semaphore calls since the previous snapshot
+#define TEL_ID_CONSUMERHIST 11  // Consumer frame times, log2 bins of OS_Time units, see Hist.h
+#define TEL_ID_DRAWHIST 12      // DrawCubes frame times, log2 bins
+#define TEL_ID_AUTOGAMES 13     // games the autoplay bot restarted
+#define TEL_ID_STEPHIST 14      // StepCubes times, log2 bins
+#define TEL_ID_WAVEHIST 15      // InitCubes times, log2 bins
+#define TEL_ID_CLEARHIST 16     // cube LCD clears, log2 bins
+#define TEL_ID_DEFERDROPPED 17  // OS_Defer work dropped because the ring was full
+#define TEL_ID_DEFERHIST 18     // joystick sample to Producer start in the OS worker, log2 bins
+#define TEL_ID_PRODUCERHIST 19  // Producer run times, log2 bins
+#define TEL_ID_PERIODICJITTER 32  // plus the OS periodic slot, release jitter in 0.1 us bins
+
+// TEL_REPLAY ids
+#define TEL_REPLAY_HEADER 0   // seeds and calibration, struct ReplayHeader
+#define TEL_REPLAY_RECORDS 1  // chunk number(4), then up to REPLAY_CHUNK 6-byte records
+
+#define TEL_MAXPAYLOAD 66
+#define TEL_HISTCHUNK 16  // histogram bins per frame
+#define TEL_TRACECHUNK 6  // trace records per frame
+#define TEL_VIOLATIONCHUNK 4  // periodic violation records per frame
+
+// number of records discarded because the ring was full
+extern unsigned long Tel_Dropped;
+
+// ******** Tel_Init ************
+// initialize the telemetry ring
+// input:  none
+// output: none
+void Tel_Init(void);
+
+// ******** Tel_Counter ************
+// queue a counter record
+// input:  record id, counter value
+// output: 1 if queued, 0 if the ring was full
+int Tel_Counter(uint8_t id, uint32_t value);
+
+// ******** Tel_Event ************
+// queue an event record
+// input:  record id, event argument
+// output: 1 if queued, 0 if the ring was full
+int Tel_Event(uint8_t id, uint32_t arg);
+
+// ******** Tel_Histogram ************
+// queue a histogram, split into frames of TEL_HISTCHUNK bins
+// shares one payload buffer, call only from the telemetry thread
+// input:  record id, pointer to the bins, number of bins (at most 255)
+// output: number of frames queued
+int Tel_Histogram(uint8_t id, const unsigned long *bins, uint16_t size);
+
+// ******** Tel_Thread ************
+// queue a per-thread statistics record
+// input:  thread id, number of times switched to, wait time before first run in ms
+// output: 1 if queued, 0 if the ring was full
+int Tel_Thread(uint8_t id, uint32_t execCount, uint32_t waitTime);
+
+// ******** Tel_Periodic ************
+// queue the statistics of one periodic task
+// input:  OS periodic slot, its statistics
+// output: 1 if queued, 0 if the ring was full
+int Tel_Periodic(uint8_t slot, const PeriodicStatsType *stats);
+
+// ******** Tel_Violations ************
+// queue up to TEL_VIOLATIONCHUNK periodic violation records in one frame
+// shares one payload buffer, call only from the telemetry thread
+// input:  pointer to the records, number of records
+// output: 1 if queued, 0 if the ring was full
+int Tel_Violations(const struct PeriodicViolation *recs, int count);
+
+// ******** Tel_Trace ************
+// queue up to TEL_TRACECHUNK kernel trace records in one frame
+// shares one payload buffer, call only from the telemetry thread
+// input:  pointer to the records, number of records
+// output: 1 if queued, 0 if the ring was full
+int Tel_Trace(const struct TraceRecord *recs, int count);
+
+// ******** Tel_Replay ************
+// queue a record and replay log frame
+// input:  TEL_REPLAY_ id, payload, payload length (at most TEL_MAXPAYLOAD)
+// output: 1 if queued, 0 if the ring was full
+int Tel_Replay(uint8_t id, const uint8_t *payload, uint16_t len);
+
+// ******** Tel_Drain ************
+// copy every queued byte to UART0
+// spins on the UART transmit FIFO, call only from a foreground thread
+// input:  none
+// output: none
+void Tel_Drain(void);
+
+#endif
@@ -30,9 +30,15 @@
 #include <stdint.h>
 #include "tm4c123gh6pm.h"
 
+#include "os.h"
+#include "DMA.h"
 #include "UART_FIFO.h"
 #include "UART.h"
 
+// Receive with the uDMA into a ring instead of one interrupt per
+// character, comment out to use the interrupt driven Rx_UARTFifo
+#define UART_RX_DMA
+
 #define NVIC_EN0_INT5 0x00000020  // Interrupt 5 enable
 
 #define UART_FR_RXFF 0x00000040      // UART Receive FIFO Full
@@ -42,6 +48,7 @@
 #define UART_LCRH_FEN 0x00000010     // UART Enable FIFOs
 #define UART_CTL_UARTEN 0x00000001   // UART Enable
 #define UART_IFLS_RX1_8 0x00000000   // RX FIFO >= 1/8 full
+#define UART_IFLS_RX4_8 0x00000010   // RX FIFO >= 1/2 full
 #define UART_IFLS_TX1_8 0x00000000   // TX FIFO <= 1/8 full
 #define UART_IM_RTIM \
     0x00000040                   // UART Receive Time-Out Interrupt
@@ -60,6 +67,7 @@
 #define UART_ICR_RTIC 0x00000040  // Receive Time-Out Interrupt Clear
 #define UART_ICR_TXIC 0x00000020  // Transmit Interrupt Clear
 #define UART_ICR_RXIC 0x00000010  // Receive Interrupt Clear
+#define UART_DMACTL_RXDMAE 0x00000001  // Receive DMA Enable
 
 void DisableInterrupts(void);  // Disable interrupts
 void EnableInterrupts(void);   // Enable interrupts
@@ -74,6 +82,83 @@ void WaitForInterrupt(void);   // low power mode
 // AddIndexFifo(Rx_UART, FIFOSIZE, char, FIFOSUCCESS, FIFOFAIL)
 // AddIndexFifo(Tx_UART, FIFOSIZE, char, FIFOSUCCESS, FIFOFAIL)
 
+#ifdef UART_RX_DMA
+// uDMA ping-pong receive into a ring of RXBLOCKS blocks.
+// The primary and alternate structures always point at two consecutive
+// blocks; when one completes, UART0_Handler points it two blocks ahead.
+// The uDMA only answers burst requests (RX FIFO half full), so the last
+// few bytes of a burst stay in the hardware FIFO until the receive
+// time-out, which marks the end of the burst and flushes them.
+#define RXRINGSIZE 256  // must be a power of 2
+#define RXBLOCK 32      // bytes per uDMA transfer, multiple of 8
+#define RXBLOCKS (RXRINGSIZE / RXBLOCK)
+#define RXCHANNEL (1 << DMA_CH_UART0RX)
+
+static uint8_t RxRing[RXRINGSIZE];
+static uint32_t volatile RxBlocksDone;  // blocks completely written by the uDMA
+static uint32_t volatile RxActiveAlt;   // structure filling block RxBlocksDone
+static uint32_t RxNextBlock;            // next block to hand to the uDMA
+static uint32_t RxGetI;                 // bytes taken by UART_InChar
+unsigned long RxOverrun;                // bytes lost because the reader fell behind
+Sema4Type RxDataReady;                  // signaled at block ends and burst ends
+
+// point one control structure at the next free block
+void static RxDmaLoad(uint32_t alt) {
+    DMA_SetTransfer(DMA_CH_UART0RX, alt, &UART0_DR_R,
+                    &RxRing[(RxNextBlock % RXBLOCKS) * RXBLOCK + RXBLOCK - 1],
+                    DMA_DSTINC_8 | DMA_DSTSIZE_8 | DMA_SRCINC_NONE | DMA_SRCSIZE_8 | DMA_ARB_8 |
+                        DMA_XFERSIZE(RXBLOCK) | DMA_MODE_PINGPONG);
+    RxNextBlock++;
+}
+
+void static RxDmaInit(void) {
+    DMA_Init();
+    OS_InitSemaphore(&RxDataReady, 0);
+    RxBlocksDone = RxActiveAlt = RxNextBlock = RxGetI = 0;
+    UDMA_ENACLR_R = RXCHANNEL;         // disable channel 8 during setup
+    UDMA_CHMAP1_R &= ~0x0000000F;      // channel 8 encoding 0 is UART0 RX
+    UDMA_PRIOCLR_R = RXCHANNEL;        // default priority
+    UDMA_ALTCLR_R = RXCHANNEL;         // start with the primary structure
+    UDMA_REQMASKCLR_R = RXCHANNEL;     // allow UART0 requests
+    RxDmaLoad(0);                      // block 0
+    RxDmaLoad(1);                      // block 1
+    UDMA_USEBURSTSET_R = RXCHANNEL;    // ignore single requests
+    UDMA_ENASET_R = RXCHANNEL;         // enable channel 8
+    UART0_DMACTL_R |= UART_DMACTL_RXDMAE;
+}
+
+// number of bytes the uDMA has written since RxDmaInit
+// call with interrupts disabled
+static uint32_t RxPutI(void) {
+    uint32_t n = RXBLOCK - DMA_Remaining(DMA_CH_UART0RX, RxActiveAlt);
+    if (n == RXBLOCK) {  // completed, UART0_Handler has not run yet
+        n += RXBLOCK - DMA_Remaining(DMA_CH_UART0RX, RxActiveAlt ^ 1);
+    }
+    return RxBlocksDone * RXBLOCK + n;
+}
+
+// take one byte from the receive ring
+// return FIFOSUCCESS if successful
+int static RxDma_Get(char *datapt) {
+    uint32_t putI;
+    long sr;
+    sr = StartCritical();
+    putI = RxPutI();
+    EndCritical(sr);
+    // the two blocks owned by the uDMA may already be overwritten
+    if (putI - RxGetI > RXRINGSIZE - 2 * RXBLOCK) {
+        RxOverrun += putI - RxGetI - (RXRINGSIZE - 2 * RXBLOCK);
+        RxGetI = putI - (RXRINGSIZE - 2 * RXBLOCK);
+    }
+    if (putI == RxGetI) {
+        return (FIFOFAIL);  // Empty
+    }
+    *datapt = RxRing[RxGetI & (RXRINGSIZE - 1)];
+    RxGetI++;
+    return (FIFOSUCCESS);
+}
+#endif
+
 // Initialize UART0
 // Baud rate is 115200 bits/sec
 void UART_Init(void) {
@@ -90,9 +175,17 @@ void UART_Init(void) {
     UART0_IFLS_R &= ~0x3F;  // clear TX and RX interrupt FIFO level fields
                             // configure interrupt for TX FIFO <= 1/8 full
                             // configure interrupt for RX FIFO >= 1/8 full
+#ifdef UART_RX_DMA
+    // configure uDMA burst requests for RX FIFO >= 1/2 full
+    UART0_IFLS_R += (UART_IFLS_TX1_8 | UART_IFLS_RX4_8);
+    RxDmaInit();
+    // enable TX FIFO interrupt and RX time-out interrupt, the uDMA takes the RX FIFO
+    UART0_IM_R = (UART0_IM_R & ~UART_IM_RXIM) | (UART_IM_TXIM | UART_IM_RTIM);
+#else
     UART0_IFLS_R += (UART_IFLS_TX1_8 | UART_IFLS_RX1_8);
     // enable TX and RX FIFO interrupts and RX time-out interrupt
     UART0_IM_R |= (UART_IM_RXIM | UART_IM_TXIM | UART_IM_RTIM);
+#endif
     UART0_CTL_R |= UART_CTL_UARTEN;  // enable UART
     GPIO_PORTA_AFSEL_R |= 0x03;      // enable alt funct on PA1-0
     GPIO_PORTA_DEN_R |= 0x03;        // enable digital I/O on PA1-0
@@ -107,7 +200,7 @@ void UART_Init(void) {
 // stop when hardware RX FIFO is empty or software RX FIFO is full
 void static copyHardwareToSoftware(void) {
     char letter;
-    while (((UART0_FR_R & UART_FR_RXFE) == 0) && (Rx_UARTFifo_Size() < (FIFOSIZE - 1))) {
+    while (((UART0_FR_R & UART_FR_RXFE) == 0) && (Rx_UARTFifo_Size() < (RXFIFOSIZE - 1))) {
         letter = UART0_DR_R;
         Rx_UARTFifo_Put(letter);
     }
@@ -125,8 +218,14 @@ void static copySoftwareToHardware(void) {
 // spin if RxFifo is empty
 char UART_InChar(void) {
     char letter;
+#ifdef UART_RX_DMA
+    while (RxDma_Get(&letter) == FIFOFAIL) {
+        OS_bWait(&RxDataReady);  // wait for the next block or burst end
+    }
+#else
     while (Rx_UARTFifo_Get(&letter) == FIFOFAIL) {
     };
+#endif
     return (letter);
 }
 // output ASCII character to UART
@@ -143,6 +242,7 @@ void UART_OutChar(char data) {
 // hardware RX FIFO goes from 1 to 2 or more items
 // UART receiver has timed out
 void UART0_Handler(void) {
+    OS_TRACE(TRACE_ISR_ENTER, TRACE_IRQ_UART0);
     if (UART0_RIS_R & UART_RIS_TXRIS) {  // hardware TX FIFO <= 2 items
         UART0_ICR_R = UART_ICR_TXIC;     // acknowledge TX FIFO
         // copy from software TX FIFO to hardware TX FIFO
@@ -151,6 +251,28 @@ void UART0_Handler(void) {
             UART0_IM_R &= ~UART_IM_TXIM;  // disable TX FIFO interrupt
         }
     }
+#ifdef UART_RX_DMA
+    if (UDMA_CHIS_R & RXCHANNEL) {  // uDMA filled at least one block
+        UDMA_CHIS_R = RXCHANNEL;    // acknowledge
+        while (DMA_Remaining(DMA_CH_UART0RX, RxActiveAlt) == 0) {
+            RxBlocksDone++;
+            RxDmaLoad(RxActiveAlt);  // reuse it two blocks ahead
+            RxActiveAlt ^= 1;
+        }
+        UDMA_USEBURSTSET_R = RXCHANNEL;  // cleared by the uDMA on a short final burst
+        UDMA_ENASET_R = RXCHANNEL;       // in case both structures had run out
+        OS_bSignal(&RxDataReady);
+    }
+    if (UART0_RIS_R & UART_RIS_RTRIS) {  // receiver timed out, end of burst
+        UART0_ICR_R = UART_ICR_RTIC;     // acknowledge receiver time out
+        // let single requests move the leftover bytes, a few bus cycles each
+        UDMA_USEBURSTCLR_R = RXCHANNEL;
+        while (((UART0_FR_R & UART_FR_RXFE) == 0) && (UDMA_ENASET_R & RXCHANNEL)) {
+        };
+        UDMA_USEBURSTSET_R = RXCHANNEL;
+        OS_bSignal(&RxDataReady);
+    }
+#else
     if (UART0_RIS_R & UART_RIS_RXRIS) {  // hardware RX FIFO >= 2 items
         UART0_ICR_R = UART_ICR_RXIC;     // acknowledge RX FIFO
         // copy from hardware RX FIFO to software RX FIFO
@@ -161,6 +283,8 @@ void UART0_Handler(void) {
         // copy from hardware RX FIFO to software RX FIFO
         copyHardwareToSoftware();
     }
+#endif
+    OS_TRACE(TRACE_ISR_EXIT, TRACE_IRQ_UART0);
 }
 
 //------------UART_OutString------------
@@ -37,6 +37,10 @@
 #define SP 0x20
 #define DEL 0x7F
 
+// bytes lost because UART_InChar fell more than the receive ring behind
+// (uDMA receive only, see UART_RX_DMA in UART.c)
+extern unsigned long RxOverrun;
+
 //------------UART_Init------------
 // Initialize the UART for 115,200 baud rate (assuming 50 MHz clock),
 // 8 bit word length, no parity bits, one stop bit, FIFOs enabled
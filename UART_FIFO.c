@@ -77,8 +77,7 @@ int Tx_UARTFifo_Get(tx_UARTDataType *datapt) {
 unsigned short Tx_UARTFifo_Size(void) { return ((unsigned short)(Tx_UARTPutI - Tx_UARTGetI)); }
 
 // Two-pointer implementation of the receive FIFO
-// can hold 0 to RXFIFOSIZE-1 elements
-#define RXFIFOSIZE 10  // can be any size
+// can hold 0 to RXFIFOSIZE-1 elements, RXFIFOSIZE is in UART_FIFO.h
 #define RXFIFOSUCCESS 1
 #define RXFIFOFAIL 0
 
@@ -4,6 +4,9 @@
 long StartCritical(void);   // previous I bit, disable interrupts
 void EndCritical(long sr);  // restore I bit to previous value
 
+// Two-pointer receive FIFO can hold 0 to RXFIFOSIZE-1 elements
+#define RXFIFOSIZE 10  // can be any size
+
 typedef char tx_UARTDataType;
 typedef char rx_UARTDataType;
 
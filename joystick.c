@@ -1,5 +1,6 @@
 #include <stdint.h>
 #include "joystick.h"
+#include "os.h"
 #include "tm4c123gh6pm.h"
 
 void DisableInterrupts(void);  // Disable interrupts
@@ -25,6 +26,7 @@ void static adcinit(void) {
     ADC0_PC_R &= ~0xF;      // 8) clear max sample rate field
     ADC0_PC_R |= 0x1;       //    configure for 125K samples/sec
     ADC0_SSPRI_R = 0x3210;  // 9) Sequencer 3 is lowest priority
+    ADC0_SAC_R = 0x4;       //    average 16 conversions in hardware per sample
                             // 10-15) sample sequencer initialization in more specific functions
 }
 
@@ -75,7 +77,13 @@ void BSP_Joystick_Init(void) {
 // Output: none
 // Assumes: BSP_Joystick_Init() has been called
 #define SELECT (*((volatile uint32_t *)0x40024040)) /* PE4 */
+static void (*JoystickTask)(void);  // 0 until timer triggered sampling starts
+static int JoystickSlot;            // the task's OS periodic slot
 void BSP_Joystick_Input(uint16_t *x, uint16_t *y, uint8_t *select) {
+    if (JoystickTask) {  // SS1 belongs to Timer0A now
+        BSP_Joystick_Sample(x, y, select);
+        return;
+    }
     ADC0_PSSI_R = 0x0002;  // 1) initiate SS1
     while ((ADC0_RIS_R & 0x02) == 0) {
     };                    // 2) wait for conversion done
@@ -84,3 +92,79 @@ void BSP_Joystick_Input(uint16_t *x, uint16_t *y, uint8_t *select) {
     *select = SELECT;     // return 0(pressed) or 0x10(not pressed)
     ADC0_ISC_R = 0x0002;  // 4) acknowledge completion
 }
+
+// latest timer-triggered sample, written by ADC0Seq1_Handler
+static uint16_t volatile SampleX, SampleY;
+static uint8_t volatile SampleSelect;
+
+// ------------BSP_Joystick_AddTask------------
+// Start Timer0A triggered sampling on sequencer 1 and
+// run task after each conversion.
+// Input: task is the function to run after each conversion
+//        period in bus cycles (12.5 ns)
+//        priority of the ADC0 SS1 interrupt (0 to 7)
+// Output: none
+void BSP_Joystick_AddTask(void (*task)(void), uint32_t period, uint32_t priority) {
+    uint16_t x, y;
+    uint8_t select;
+    long sr;
+    sr = StartCritical();
+    BSP_Joystick_Input(&x, &y, &select);     // valid sample before the first trigger
+    SampleX = x;
+    SampleY = y;
+    SampleSelect = select;
+    JoystickTask = task;
+    JoystickSlot = OS_AddPeriodicSource(task, period);  // the OS times every release
+    SYSCTL_RCGCTIMER_R |= 0x01;              // activate timer0
+    while ((SYSCTL_PRTIMER_R & 0x01) == 0) {
+    };                                       // allow time for clock to stabilize
+    TIMER0_CTL_R &= ~TIMER_CTL_TAEN;         // 1) disable timer0A during setup
+    TIMER0_CFG_R = TIMER_CFG_32_BIT_TIMER;   // 2) 32-bit timer mode
+    TIMER0_TAMR_R = TIMER_TAMR_TAMR_PERIOD;  // 3) periodic mode, down-count
+    TIMER0_TAILR_R = period - 1;             // 4) reload value
+    TIMER0_TAPR_R = 0;
+    TIMER0_IMR_R = 0;                        // 5) no timer interrupt, the ADC interrupts
+    TIMER0_CTL_R |= TIMER_CTL_TAOTE;         // 6) timeout triggers the ADC
+    ADC0_ACTSS_R &= ~0x0002;                 // 7) disable sample sequencer 1
+    ADC0_EMUX_R = (ADC0_EMUX_R & ~0x00F0) | 0x0050;  // 8) seq1 is timer trigger
+    ADC0_ISC_R = 0x0002;                     // 9) clear any stale completion
+    ADC0_IM_R |= 0x0002;                     // 10) enable SS1 interrupts
+    ADC0_ACTSS_R |= 0x0002;                  // 11) enable sample sequencer 1
+    // 12) priority shifted to bits 31-29 for ADC0 SS1 (interrupt 15)
+    NVIC_PRI3_R = (NVIC_PRI3_R & 0x1FFFFFFF) | (priority << 29);
+    NVIC_EN0_R = NVIC_EN0_INT15;             // 13) enable interrupt 15 in NVIC
+    TIMER0_CTL_R |= TIMER_CTL_TAEN;          // 14) enable timer0A
+    EndCritical(sr);
+}
+
+// ------------BSP_Joystick_Sample------------
+// Return the sample latched by the most recent
+// timer-triggered conversion.
+// Input: x is pointer to store X-position (0 to 4095)
+//        y is pointer to store Y-position (0 to 4095)
+//        select is pointer to store Select status (0 if pressed)
+// Output: none
+void BSP_Joystick_Sample(uint16_t *x, uint16_t *y, uint8_t *select) {
+    long sr;
+    sr = StartCritical();  // keep x and y from the same conversion
+    *x = SampleX;
+    *y = SampleY;
+    *select = SampleSelect;
+    EndCritical(sr);
+}
+
+// Sequencer 1 finished the conversion that Timer0A started,
+// latch it and run the task.
+void ADC0Seq1_Handler(void) {
+    OS_TRACE(TRACE_ISR_ENTER, TRACE_IRQ_ADC0SS1);
+    ADC0_ISC_R = 0x0002;  // acknowledge completion
+    SampleX = ADC0_SSFIFO1_R;
+    SampleY = ADC0_SSFIFO1_R;
+    SampleSelect = SELECT;
+    if (JoystickSlot >= 0) {
+        OS_PeriodicRun(JoystickSlot);
+    } else {
+        (*JoystickTask)();  // no periodic slot left, run it untimed
+    }
+    OS_TRACE(TRACE_ISR_EXIT, TRACE_IRQ_ADC0SS1);
+}
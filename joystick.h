@@ -13,9 +13,39 @@ void BSP_Joystick_Init(void);
 // button is not considered.  The joystick X- and
 // Y-positions are returned as 10-bit numbers,
 // even if the ADC on the LaunchPad is more precise.
+// Once BSP_Joystick_AddTask() has started timer
+// triggered sampling, this returns the latest sample.
 // Input: x is pointer to store X-position (0 to 1023)
 //        y is pointer to store Y-position (0 to 1023)
 //        select is pointer to store Select status (0 if pressed)
 // Output: none
 // Assumes: BSP_Joystick_Init() has been called
 void BSP_Joystick_Input(uint16_t *x, uint16_t *y, uint8_t *select);
+
+// ------------BSP_Joystick_AddTask------------
+// Sample the joystick in hardware instead of by software.
+// Timer0A triggers ADC0 sample sequencer 1 at a fixed
+// period, and the sequencer completion interrupt latches
+// X, Y and Select and then runs the task.  Sampling time
+// therefore depends only on the hardware timer, not on
+// which interrupt happens to be running.
+// The task runs inside ADC0Seq1_Handler with the same
+// restrictions as an OS periodic thread, and reads the
+// sample with BSP_Joystick_Sample.
+// Input: task is the function to run after each conversion
+//        period in bus cycles (12.5 ns)
+//        priority of the ADC0 SS1 interrupt (0 to 7)
+// Output: none
+// Assumes: BSP_Joystick_Init() has been called
+void BSP_Joystick_AddTask(void (*task)(void), uint32_t period, uint32_t priority);
+
+// ------------BSP_Joystick_Sample------------
+// Return the sample latched by the most recent
+// timer-triggered conversion, same format as
+// BSP_Joystick_Input.
+// Input: x is pointer to store X-position (0 to 4095)
+//        y is pointer to store Y-position (0 to 4095)
+//        select is pointer to store Select status (0 if pressed)
+// Output: none
+// Assumes: BSP_Joystick_AddTask() has been called
+void BSP_Joystick_Sample(uint16_t *x, uint16_t *y, uint8_t *select);
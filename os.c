@@ -38,15 +38,35 @@ void EndCritical(long sr);        // restore I bit to previous value
 void WaitForInterrupt(void);      // low power mode
 void StartOS(void);
 
-// Periodic task function pointers
-void (*PeriodicTask1)(void);
-void (*PeriodicTask2)(void);
-
-// Button task function pointers
-void (*ButtonOneTask)(void);
-void (*ButtonTwoTask)(void);
+// Software timers
+static OSTimerType *Timers;     // every created timer, walked by the 1 ms tick
+static FlagsType TimerExpired;  // bit 0 set by the tick when a timer expires
+static void TimerDaemon(void);
+
+// Deferred work, queued by ISRs and run by DeferWorker
+struct DeferredWork {
+    void (*Task)(uint32_t arg);
+    uint32_t Arg;
+};
+static struct DeferredWork DeferRing[OS_DEFERSIZE];
+static uint32_t volatile DeferPutI;  // work items queued since boot
+static uint32_t volatile DeferGetI;  // work items taken by the worker
+static Sema4Type DeferCount;         // items in the ring
+unsigned long OS_DeferDropped;
+static void DeferWorker(void);
+
+// Periodic tasks, the slots of OS_AddPeriodicThread are released by Timer1A
+static PeriodicStatsType Periodic[OS_MAXPERIODIC];
+static int NumPeriodic;
+static uint8_t TimerOrder[OS_MAXPERIODIC];  // Timer1A slots, shortest period first
+static int NumTimed;
+static unsigned long TimerPriority;  // highest priority asked for, Timer1A runs at it
+static void PeriodicArm(void);
+static struct PeriodicViolation Violations[OS_VIOLATIONSIZE];
+static unsigned long ViolationPutI;  // violations recorded since boot
+
+static uint32_t TickTime;  // ms since OS_Init, unlike MSTime never cleared
 
-#define NUMTHREADS 20  // Maximum number of threads
 #define STACKSIZE 100  // Number of 32-bit words in stack
 
 // Macros
@@ -55,6 +75,13 @@ void (*ButtonTwoTask)(void);
 // scheduler
 //#define aging										// Dynamic
 // priority scheculer with aging
+//#define edfSched  // earliest deadline first among threads that called OS_SetPeriod
+// needs blockSema like prioritySched: with spinning semaphores a periodic
+// thread waiting in OS_Wait stays ready, and EDF would keep running it
+// instead of the thread that holds the semaphore
+#if defined(edfSched) && !defined(blockSema)
+#error "edfSched needs blockSema"
+#endif
 
 // TCB Data Structure
 struct tcb {
@@ -66,8 +93,18 @@ struct tcb {
     uint32_t ArriveTime;  // First time thread is added to the system
     uint32_t WaitTime;    // Elapsed time since thread arrived till it starts execution
     uint32_t ExecCount;   // Number of times thread is executed (switched to)
+    uint32_t Period;      // ms between job releases, 0 until OS_SetPeriod
+    uint32_t Deadline;    // ms after its release each job has to finish in
+    uint32_t Release;     // TickTime the current job was released
+    uint32_t Jobs;        // jobs finished with OS_WaitNextPeriod
+    uint32_t Misses;      // jobs that finished after their deadline
+#ifdef edfSched
+    uint32_t BottomHalf;  // added at priority 0, runs ahead of every periodic job
+#endif
 #ifdef blockSema
-    Sema4Type *blockPt;  // Pointer to resource thread is blocked on (0 if not)
+    Sema4Type *blockPt;      // Pointer to resource thread is blocked on (0 if not)
+    unsigned long waitBits;  // flags a thread blocked in OS_FlagsWait needs
+    int waitMode;            // and whether it needs any or all of them
 #endif
 #ifdef prioritySched
 #ifdef aging
@@ -101,6 +138,10 @@ void OS_Init(void) {
         TIME_1MS);  // initialize Timer2A which is used for software timer and decrease the sleepCt
     InitTimer3A();
     OS_ClearMsTime();
+    OS_FlagsInit(&TimerExpired, 0);
+    OS_AddThread(&TimerDaemon, 128, 0);  // runs the software timer callbacks
+    OS_InitSemaphore(&DeferCount, 0);
+    OS_AddThread(&DeferWorker, 128, 0);  // runs the work ISRs defer
 
     NVIC_ST_CTRL_R = 0;     // disable SysTick during setup
     NVIC_ST_CURRENT_R = 0;  // any write to current clears it
@@ -138,6 +179,17 @@ void OS_Launch(unsigned long theTimeSlice) {
     StartOS();                            // start on the first task
 }
 
+// ******** OS_SetTimeSlice ************
+// change the time slice while running, takes effect on the next SysTick reload
+// Inputs: number of 12.5ns clock cycles for each time slice (maximum of 24 bits)
+// Outputs: none
+void OS_SetTimeSlice(unsigned long theTimeSlice) { NVIC_ST_RELOAD_R = theTimeSlice - 1; }
+
+// ******** OS_TimeSlice ************
+// Inputs: none
+// Outputs: number of 12.5ns clock cycles for each time slice
+unsigned long OS_TimeSlice(void) { return NVIC_ST_RELOAD_R + 1; }
+
 // ******** OS_Suspend ************
 // suspend execution of currently running thread
 // scheduler will choose another thread to execute
@@ -163,6 +215,7 @@ int OS_AddThread(void (*task)(void), unsigned long stackSize, unsigned long prio
     int32_t status, thread;
     status = StartCritical();
     if (ThreadNum == NUMTHREADS) {  // no available tcbs
+        EndCritical(status);
         return 0;
     } else {
         if (ThreadNum == 0) {  // start add thread
@@ -188,6 +241,12 @@ int OS_AddThread(void (*task)(void), unsigned long stackSize, unsigned long prio
         tcbs[thread].WaitTime = 0;  // Initially 0
         tcbs[thread].ArriveTime = OS_MsTime();
         tcbs[thread].ExecCount = 0;  // Initially 0
+        tcbs[thread].Period = 0;     // not periodic until OS_SetPeriod
+        tcbs[thread].Jobs = 0;
+        tcbs[thread].Misses = 0;
+#ifdef edfSched
+        tcbs[thread].BottomHalf = (priority == 0);  // TimerDaemon and DeferWorker
+#endif
 
 #ifdef prioritySched
 #ifdef aging
@@ -201,6 +260,7 @@ int OS_AddThread(void (*task)(void), unsigned long stackSize, unsigned long prio
         SetInitialStack(thread);
         Stacks[thread][STACKSIZE - 2] = (int32_t)(task);  // PC
         ThreadNum++;
+        OS_TRACE(TRACE_CREATE, thread);
         EndCritical(status);
         return 1;
     }
@@ -212,6 +272,50 @@ int OS_AddThread(void (*task)(void), unsigned long stackSize, unsigned long prio
 // Outputs: Thread ID, number greater than zero
 unsigned long OS_Id(void) { return RunPt->id; }
 
+//******** OS_ThreadStats ***************
+// reads the statistics kept in one TCB
+// Inputs: TCB slot, 0 to NUMTHREADS-1
+//         pointers to store the thread ID, the number of times the thread
+//         was switched to and its wait time before first running in ms
+// Outputs: 1 if the slot holds a live thread, 0 otherwise
+int OS_ThreadStats(uint32_t slot, uint32_t *id, uint32_t *execCount, uint32_t *waitTime) {
+    int32_t status;
+    if (slot >= NUMTHREADS) return 0;
+    status = StartCritical();
+    if (tcbs[slot].available) {
+        EndCritical(status);
+        return 0;
+    }
+    *id = tcbs[slot].id;
+    *execCount = tcbs[slot].ExecCount;
+    *waitTime = tcbs[slot].WaitTime;
+    EndCritical(status);
+    return 1;
+}
+
+//******** OS_ThreadDeadlines ***************
+// reads the deadline accounting kept in one TCB
+// Inputs: TCB slot, 0 to NUMTHREADS-1
+//         pointers to store the period in ms (0 if the thread is not periodic),
+//         the jobs it finished and how many of them missed their deadline
+// Outputs: 1 if the slot holds a live thread, 0 otherwise
+int OS_ThreadDeadlines(uint32_t slot, uint32_t *period, uint32_t *jobs, uint32_t *misses) {
+    int32_t status;
+    if (slot >= NUMTHREADS) return 0;
+    status = StartCritical();
+    if (tcbs[slot].available) {
+        EndCritical(status);
+        return 0;
+    }
+    *period = tcbs[slot].Period;
+    *jobs = tcbs[slot].Jobs;
+    *misses = tcbs[slot].Misses;
+    EndCritical(status);
+    return 1;
+}
+
+unsigned long OS_SemaphoreOps;  // semaphore calls since boot, for profiling
+
 // ******** OS_Wait ************
 // decrement semaphore
 // input:  pointer to a counting semaphore
@@ -219,8 +323,11 @@ unsigned long OS_Id(void) { return RunPt->id; }
 void OS_Wait(Sema4Type *semaPt) {
 #ifdef blockSema
     OS_DisableInterrupts();
+    OS_TRACE(TRACE_WAIT, semaPt);
+    OS_SemaphoreOps++;
     semaPt->Value -= 1;
     if (semaPt->Value < 0) {
+        OS_TRACE(TRACE_BLOCK, semaPt);
         RunPt->blockPt = semaPt;
         OS_EnableInterrupts();
         OS_Suspend();
@@ -229,6 +336,11 @@ void OS_Wait(Sema4Type *semaPt) {
     OS_EnableInterrupts();
 #else
     OS_DisableInterrupts();
+    OS_TRACE(TRACE_WAIT, semaPt);
+    OS_SemaphoreOps++;
+    if (semaPt->Value == 0) {
+        OS_TRACE(TRACE_BLOCK, semaPt);
+    }
     while (semaPt->Value == 0) {
         OS_EnableInterrupts();
         OS_Suspend();
@@ -238,14 +350,12 @@ void OS_Wait(Sema4Type *semaPt) {
 #endif
 }
 
-// ******** OS_Signal ************
-// increment semaphore
-// input:  pointer to a counting semaphore
-// output: none
-void OS_Signal(Sema4Type *semaPt) {
+// increment semaphore, call with interrupts disabled
+static void SignalLocked(Sema4Type *semaPt) {
 #ifdef blockSema
     tcbType *pt;
-    OS_DisableInterrupts();
+    OS_TRACE(TRACE_SIGNAL, semaPt);
+    OS_SemaphoreOps++;
     semaPt->Value += 1;
     if (semaPt->Value <= 0) {
         pt = RunPt->next;
@@ -254,14 +364,25 @@ void OS_Signal(Sema4Type *semaPt) {
         }
         pt->blockPt = 0;  // wake up this one
     }
-    OS_EnableInterrupts();
 #else
-    OS_DisableInterrupts();
+    OS_TRACE(TRACE_SIGNAL, semaPt);
+    OS_SemaphoreOps++;
     semaPt->Value += 1;
-    OS_EnableInterrupts();
 #endif
 }
 
+// ******** OS_Signal ************
+// increment semaphore
+// enables interrupts on return, inside a critical section use the
+// caller's own (OS_Defer does)
+// input:  pointer to a counting semaphore
+// output: none
+void OS_Signal(Sema4Type *semaPt) {
+    OS_DisableInterrupts();
+    SignalLocked(semaPt);
+    OS_EnableInterrupts();
+}
+
 // ******** OS_InitSemaphore ************
 // initialize semaphore
 // input:  pointer to a semaphore
@@ -278,8 +399,11 @@ void OS_InitSemaphore(Sema4Type *semaPt, long value) {
 void OS_bWait(Sema4Type *semaPt) {
 #ifdef blockSema
     OS_DisableInterrupts();
+    OS_TRACE(TRACE_WAIT, semaPt);
+    OS_SemaphoreOps++;
     semaPt->Value -= 1;
     if (semaPt->Value < 0) {
+        OS_TRACE(TRACE_BLOCK, semaPt);
         RunPt->blockPt = semaPt;
         OS_EnableInterrupts();
         OS_Suspend();
@@ -287,6 +411,11 @@ void OS_bWait(Sema4Type *semaPt) {
     OS_EnableInterrupts();
 #else
     OS_DisableInterrupts();
+    OS_TRACE(TRACE_WAIT, semaPt);
+    OS_SemaphoreOps++;
+    if (semaPt->Value == 0) {
+        OS_TRACE(TRACE_BLOCK, semaPt);
+    }
     while (semaPt->Value == 0) {
         OS_EnableInterrupts();
         OS_Suspend();
@@ -304,6 +433,8 @@ void OS_bSignal(Sema4Type *semaPt) {
 #ifdef blockSema
     tcbType *pt;
     OS_DisableInterrupts();
+    OS_TRACE(TRACE_SIGNAL, semaPt);
+    OS_SemaphoreOps++;
     (semaPt->Value)++;
     if (semaPt->Value > 1) semaPt->Value = 1;
     if (semaPt->Value <= 0) {
@@ -316,11 +447,321 @@ void OS_bSignal(Sema4Type *semaPt) {
     OS_EnableInterrupts();
 #else
     OS_DisableInterrupts();
+    OS_TRACE(TRACE_SIGNAL, semaPt);
+    OS_SemaphoreOps++;
     semaPt->Value = 1;
     OS_EnableInterrupts();
 #endif
 }
 
+// wake every waiter and start the next phase, call with interrupts disabled
+static void BarrierRelease(BarrierType *barPt) {
+#ifdef blockSema
+    tcbType *pt;
+#endif
+    OS_TRACE(TRACE_SIGNAL, barPt);
+    barPt->Arrived = 0;
+    barPt->Phase++;
+#ifdef blockSema
+    pt = RunPt->next;
+    while (pt != RunPt) {
+        if (pt->blockPt == &barPt->Gate) {
+            pt->blockPt = 0;
+        }
+        pt = pt->next;
+    }
+#endif
+}
+
+// ******** OS_BarrierInit ************
+// initialize a barrier
+// input:  pointer to a barrier, number of participants
+// output: none
+void OS_BarrierInit(BarrierType *barPt, long count) {
+    OS_DisableInterrupts();
+    barPt->Count = count;
+    barPt->Arrived = 0;
+    barPt->Phase = 0;
+    barPt->Gate.Value = 0;
+    OS_EnableInterrupts();
+}
+
+// ******** OS_BarrierWait ************
+// arrive at the barrier and wait until every participant has arrived
+// input:  pointer to a barrier
+// output: 1 for the participant that completed the phase, 0 for the others
+int OS_BarrierWait(BarrierType *barPt) {
+    unsigned long phase;
+    OS_DisableInterrupts();
+    OS_TRACE(TRACE_WAIT, barPt);
+    phase = barPt->Phase;
+    barPt->Arrived++;
+    if (barPt->Arrived >= barPt->Count) {
+        BarrierRelease(barPt);
+        OS_EnableInterrupts();
+        return 1;
+    }
+    OS_TRACE(TRACE_BLOCK, barPt);
+#ifdef blockSema
+    RunPt->blockPt = &barPt->Gate;
+#endif
+    while (barPt->Phase == phase) {
+        OS_EnableInterrupts();
+        OS_Suspend();
+        OS_DisableInterrupts();
+    }
+    OS_EnableInterrupts();
+    return 0;
+}
+
+// ******** OS_BarrierJoin ************
+// add one participant, takes part from the current phase on
+// input:  pointer to a barrier
+// output: none
+void OS_BarrierJoin(BarrierType *barPt) {
+    OS_DisableInterrupts();
+    barPt->Count++;
+    OS_EnableInterrupts();
+}
+
+// ******** OS_BarrierLeave ************
+// remove one participant without arriving, releases the others
+// if they were only waiting for this one
+// input:  pointer to a barrier
+// output: none
+void OS_BarrierLeave(BarrierType *barPt) {
+    OS_DisableInterrupts();
+    if (barPt->Count > 0) {
+        barPt->Count--;
+    }
+    if (barPt->Arrived > 0 && barPt->Arrived >= barPt->Count) {
+        BarrierRelease(barPt);
+    }
+    OS_EnableInterrupts();
+}
+
+// check a flag wait condition
+static int FlagsReady(unsigned long value, unsigned long bits, int mode) {
+    if (mode & OS_FLAGS_ALL) {
+        return (value & bits) == bits;
+    }
+    return (value & bits) != 0;
+}
+
+// ******** OS_FlagsInit ************
+// initialize an event flag group
+// input:  pointer to a flag group, initial bits
+// output: none
+void OS_FlagsInit(FlagsType *flagsPt, unsigned long value) {
+    long sr;
+    sr = StartCritical();
+    flagsPt->Value = value;
+    flagsPt->Gate.Value = 0;
+    EndCritical(sr);
+}
+
+// ******** OS_FlagsSet ************
+// set bits and wake the threads waiting for them
+// can be called from an ISR
+// input:  pointer to a flag group, bits to set
+// output: none
+void OS_FlagsSet(FlagsType *flagsPt, unsigned long bits) {
+#ifdef blockSema
+    tcbType *pt;
+    int i;
+#endif
+    long sr;
+    sr = StartCritical();
+    OS_TRACE(TRACE_SIGNAL, flagsPt);
+    flagsPt->Value |= bits;
+#ifdef blockSema
+    for (i = 0, pt = RunPt; i < ThreadNum; i++, pt = pt->next) {
+        if (pt->blockPt == &flagsPt->Gate &&
+            FlagsReady(flagsPt->Value, pt->waitBits, pt->waitMode)) {
+            pt->blockPt = 0;  // only the threads this set satisfies
+        }
+    }
+#endif
+    EndCritical(sr);
+}
+
+// ******** OS_FlagsClear ************
+// clear bits, never wakes anybody
+// input:  pointer to a flag group, bits to clear
+// output: none
+void OS_FlagsClear(FlagsType *flagsPt, unsigned long bits) {
+    long sr;
+    sr = StartCritical();
+    flagsPt->Value &= ~bits;
+    EndCritical(sr);
+}
+
+// ******** OS_FlagsWait ************
+// wait until any or all of the bits are set
+// input:  pointer to a flag group, bits to wait for,
+//         OS_FLAGS_ANY or OS_FLAGS_ALL, optionally or'ed with OS_FLAGS_CLEAR
+// output: the waited for bits that were set when the thread woke up
+unsigned long OS_FlagsWait(FlagsType *flagsPt, unsigned long bits, int mode) {
+    unsigned long got;
+    OS_DisableInterrupts();
+    OS_TRACE(TRACE_WAIT, flagsPt);
+    if (!FlagsReady(flagsPt->Value, bits, mode)) {
+        OS_TRACE(TRACE_BLOCK, flagsPt);
+    }
+    while (!FlagsReady(flagsPt->Value, bits, mode)) {
+#ifdef blockSema
+        RunPt->waitBits = bits;
+        RunPt->waitMode = mode;
+        RunPt->blockPt = &flagsPt->Gate;
+#endif
+        OS_EnableInterrupts();
+        OS_Suspend();
+        OS_DisableInterrupts();
+    }
+    got = flagsPt->Value & bits;
+    if (mode & OS_FLAGS_CLEAR) {
+        flagsPt->Value &= ~got;
+    }
+    OS_EnableInterrupts();
+    return got;
+}
+
+// Software timers -------------------------------------------------------------------------
+
+// ******** OS_TimerCreate ************
+// register a stopped software timer, call once per timer
+// input:  pointer to a timer, callback, period in ms or 0 for a one-shot
+// output: none
+void OS_TimerCreate(OSTimerType *timerPt, void (*task)(void), unsigned long period) {
+    long sr;
+    sr = StartCritical();
+    timerPt->Task = task;
+    timerPt->Period = period;
+    timerPt->Remaining = 0;
+    timerPt->Active = 0;
+    timerPt->Pending = 0;
+    timerPt->Next = Timers;
+    Timers = timerPt;
+    EndCritical(sr);
+}
+
+// ******** OS_TimerStart ************
+// start a stopped timer, does nothing if it is already running
+// input:  pointer to a timer, ms until the first callback (at least 1)
+// output: none
+void OS_TimerStart(OSTimerType *timerPt, unsigned long delay) {
+    long sr;
+    sr = StartCritical();
+    if (!timerPt->Active) {
+        timerPt->Remaining = delay ? delay : 1;
+        timerPt->Active = 1;
+    }
+    EndCritical(sr);
+}
+
+// ******** OS_TimerRestart ************
+// (re)start a timer from now, dropping an expiry not yet handled
+// input:  pointer to a timer, ms until the first callback (at least 1)
+// output: none
+void OS_TimerRestart(OSTimerType *timerPt, unsigned long delay) {
+    long sr;
+    sr = StartCritical();
+    timerPt->Remaining = delay ? delay : 1;
+    timerPt->Pending = 0;
+    timerPt->Active = 1;
+    EndCritical(sr);
+}
+
+// ******** OS_TimerCancel ************
+// stop a timer, its callback will not run until it is started again
+// input:  pointer to a timer
+// output: none
+void OS_TimerCancel(OSTimerType *timerPt) {
+    long sr;
+    sr = StartCritical();
+    timerPt->Active = 0;
+    timerPt->Pending = 0;
+    EndCritical(sr);
+}
+
+// count the active timers down, called from the 1 ms tick
+static void TimerTick(void) {
+    OSTimerType *pt;
+    int expired = 0;
+    for (pt = Timers; pt; pt = pt->Next) {
+        if (pt->Active && --pt->Remaining == 0) {
+            pt->Pending = 1;
+            expired = 1;
+            if (pt->Period) {
+                pt->Remaining = pt->Period;
+            } else {
+                pt->Active = 0;
+            }
+        }
+    }
+    if (expired) {
+        OS_FlagsSet(&TimerExpired, 1);
+    }
+}
+
+// runs the callbacks of expired timers, one thread for all timers
+static void TimerDaemon(void) {
+    OSTimerType *pt;
+    long sr;
+    int run;
+    while (1) {
+        OS_FlagsWait(&TimerExpired, 1, OS_FLAGS_ANY | OS_FLAGS_CLEAR);
+        for (pt = Timers; pt; pt = pt->Next) {
+            sr = StartCritical();
+            run = pt->Pending;
+            pt->Pending = 0;
+            EndCritical(sr);
+            if (run) {
+                pt->Task();
+            }
+        }
+    }
+}
+
+// ******** OS_Defer ************
+// queue a function for the worker thread, callable from ISRs
+// and from inside critical sections: the worker is signaled under the
+// caller's interrupt state, which OS_Signal would enable
+// input:  function to run, argument to pass it
+// output: 1 if queued, 0 if the ring was full
+int OS_Defer(void (*task)(uint32_t arg), uint32_t arg) {
+    struct DeferredWork *pt;
+    long sr;
+    sr = StartCritical();  // ISRs of any priority can defer
+    if (DeferPutI - DeferGetI == OS_DEFERSIZE) {
+        OS_DeferDropped++;
+        EndCritical(sr);
+        return 0;
+    }
+    pt = &DeferRing[DeferPutI & (OS_DEFERSIZE - 1)];
+    pt->Task = task;
+    pt->Arg = arg;
+    DeferPutI++;
+    SignalLocked(&DeferCount);
+    EndCritical(sr);
+    return 1;
+}
+
+// ******** DeferWorker ************
+// the OS worker thread, runs deferred work in the order it was queued,
+// one thread for every ISR; the slot is freed before the work runs
+// input:  none
+// output: none
+static void DeferWorker(void) {
+    struct DeferredWork work;
+    while (1) {
+        OS_Wait(&DeferCount);
+        work = DeferRing[DeferGetI & (OS_DEFERSIZE - 1)];
+        DeferGetI++;  // the slot is free before the work runs, so it can defer more
+        work.Task(work.Arg);
+    }
+}
+
 // ******** OS_Sleep ************
 // place this thread into a dormant state
 // input:  number of msec to sleep
@@ -331,6 +772,44 @@ void OS_Sleep(unsigned long sleepTime) {
     OS_Suspend();
 }
 
+// ******** OS_SetPeriod ************
+// make the running thread periodic, the first call releases its first job now
+// and later calls change the period and deadline from the next release on
+// input:  ms between releases, 0 to stop being periodic
+//         ms after each release its job has to finish in
+// output: none
+void OS_SetPeriod(unsigned long period, unsigned long deadline) {
+    long sr = StartCritical();
+    if (RunPt->Period == 0) {
+        RunPt->Release = TickTime;
+    }
+    RunPt->Period = period;
+    RunPt->Deadline = deadline;
+    EndCritical(sr);
+}
+
+// ******** OS_WaitNextPeriod ************
+// finish the running thread's current job, count a miss if it is past its
+// deadline, and sleep until the next release
+// a job released more than a period ago is released again right away
+// input:  none
+// output: none
+void OS_WaitNextPeriod(void) {
+    long sr = StartCritical();
+    uint32_t now = TickTime;
+    if ((int32_t)(now - (RunPt->Release + RunPt->Deadline)) > 0) {
+        RunPt->Misses++;
+    }
+    RunPt->Jobs++;
+    RunPt->Release += RunPt->Period;
+    if ((int32_t)(RunPt->Release - now) < 0) {
+        RunPt->Release = now;  // too late for that release, skip it
+    }
+    RunPt->sleepCt = RunPt->Release - now;
+    EndCritical(sr);
+    OS_Suspend();
+}
+
 // ******** OS_Kill ************
 // kill the currently running thread, release its TCB and stack
 // input:  none
@@ -340,6 +819,7 @@ void OS_Kill(void) {
     int32_t thread;
     RunPt->available = 1;
     thread = OS_Id();
+    OS_TRACE(TRACE_KILL, thread);
     for (i = (thread + NUMTHREADS - 1) % NUMTHREADS; i != thread;
          i = (i + NUMTHREADS - 1) % NUMTHREADS) {
         if (tcbs[i].available == 0) break;  // find the previous used tcb
@@ -349,8 +829,37 @@ void OS_Kill(void) {
     OS_Suspend();  // switch the thread
 }
 
+#ifdef edfSched
+#define READY(pt) ((pt)->sleepCt == 0 && (pt)->blockPt == 0)
+
+// 1 if EDF runs a before b: the kernel bottom halves first, so timer
+// callbacks and work deferred by ISRs never wait behind a periodic job,
+// then the periodic thread whose job is due first, then the rest
+static int EdfBefore(tcbType *a, tcbType *b) {
+    if (a->BottomHalf != b->BottomHalf) return a->BottomHalf;
+    if (a->Period == 0) return 0;
+    if (b->Period == 0) return 1;
+    return (int32_t)((a->Release + a->Deadline) - (b->Release + b->Deadline)) < 0;
+}
+#endif
+
 void Scheduler(void) {
-#ifdef blockSema
+#ifdef edfSched  // earliest deadline first, blockSema is defined too
+    tcbType *pt;
+    tcbType *bestPt = 0;  // first in EDF order, ties go round robin from RunPt
+    // one pass finds a thread: SysTick_Handler calls this with interrupts
+    // disabled, so no tick can wake one meanwhile, and like the other
+    // schedulers this needs a thread that never sleeps or blocks
+    // (IdleThread in Main.c), or it would pick none
+    pt = RunPt->next;
+    do {
+        if (READY(pt) && (bestPt == 0 || EdfBefore(pt, bestPt))) {
+            bestPt = pt;
+        }
+        pt = pt->next;
+    } while (pt != RunPt->next);
+    RunPt = bestPt;
+#elif defined(blockSema)
 #ifdef prioritySched
     uint32_t max = 255;  // max priority
     tcbType *pt;
@@ -390,6 +899,7 @@ void Scheduler(void) {
 #endif
     if (RunPt->ExecCount == 0) RunPt->WaitTime = OS_MsTime() - RunPt->ArriveTime;
     RunPt->ExecCount += 1;
+    OS_TRACE(TRACE_SWITCH, RunPt->id);
 }
 
 //******** OS_AddPeriodicThread ***************
@@ -405,18 +915,274 @@ void Scheduler(void) {
 // This task can call OS_Signal  OS_bSignal	 OS_AddThread
 // This task does not have a Thread ID
 int OS_AddPeriodicThread(void (*task)(void), unsigned long period, unsigned long priority) {
-    static uint16_t PeriodTaskCt;
-    if (PeriodTaskCt == 0) {
-        PeriodicTask1 = task;
-        InitTimer1A(period, priority);
-    } else {
-        PeriodicTask2 = task;
-        InitTimer4A(period, priority);
+    int slot, i;
+    long sr;
+    slot = OS_AddPeriodicSource(task, period);
+    if (slot < 0) {
+        return 0;
+    }
+    sr = StartCritical();
+    for (i = NumTimed; i > 0 && Periodic[TimerOrder[i - 1]].Period > period; i--) {
+        TimerOrder[i] = TimerOrder[i - 1];  // rate monotonic, shorter periods go first
     }
-    PeriodTaskCt++;
+    TimerOrder[i] = slot;
+    NumTimed++;
+    Periodic[slot].Next = OS_Time() + period;
+    if (NumTimed == 1) {
+        TimerPriority = priority;
+        InitTimer1A(priority);
+    } else if (priority < TimerPriority) {
+        TimerPriority = priority;  // raise it without stopping the running timer
+        NVIC_PRI5_R = (NVIC_PRI5_R & 0xFFFF00FF) | (priority << 13);
+    }
+    PeriodicArm();
+    EndCritical(sr);
     return 1;
 }
 
+// load Timer1A with the time to the earliest release
+// call with interrupts disabled or from Timer1A_Handler
+static void PeriodicArm(void) {
+    unsigned long now = OS_Time();
+    long wait, soonest = 0x7FFFFFFF;
+    int i;
+    for (i = 0; i < NumTimed; i++) {
+        wait = (long)(Periodic[TimerOrder[i]].Next - now);
+        if (wait < soonest) {
+            soonest = wait;
+        }
+    }
+    if (soonest < PERIODIC_MINWAIT) {
+        soonest = PERIODIC_MINWAIT;  // due already, interrupt as soon as possible
+    }
+    TIMER1_CTL_R &= ~TIMER_CTL_TAEN;  // stop it, a reload while counting may be missed
+    TIMER1_TAILR_R = soonest - 1;
+    TIMER1_CTL_R |= TIMER_CTL_TAEN;   // counts down from the new reload
+}
+
+// ******** OS_AddPeriodicSource ************
+// register a periodic task that a driver interrupt releases
+// the driver calls OS_PeriodicRun with the returned slot instead of the task
+// input:  pointer to a void/void background function
+//         period given in system time units (12.5ns)
+// output: periodic slot, or -1 if all OS_MAXPERIODIC are taken
+int OS_AddPeriodicSource(void (*task)(void), unsigned long period) {
+    PeriodicStatsType *p;
+    long sr;
+    int i;
+    sr = StartCritical();
+    if (NumPeriodic == OS_MAXPERIODIC) {
+        EndCritical(sr);
+        return -1;
+    }
+    p = &Periodic[NumPeriodic];
+    p->Task = task;
+    p->Period = period;
+    p->Releases = 0;
+    p->MaxJitter = 0;
+    p->MaxExec = 0;
+    p->Overruns = 0;
+    p->LongRuns = 0;
+    p->Lost = 0;
+    p->Nested = 0;
+    p->Overrun = 0;
+    p->Running = 0;
+    for (i = 0; i < OS_JITTERSIZE; i++) {
+        p->Jitter[i] = 0;
+    }
+    NumPeriodic++;
+    EndCritical(sr);
+    return NumPeriodic - 1;
+}
+
+// count a violation and write it to the ring, overwriting the oldest record
+static void PeriodicViolation(int slot, uint8_t kind, unsigned long start, unsigned long finish) {
+    PeriodicStatsType *p = &Periodic[slot];
+    struct PeriodicViolation *v;
+    long sr;
+    p->Overruns++;
+    p->Overrun = 1;
+    if (kind & PERIODIC_LONGRUN) p->LongRuns++;
+    if (kind & PERIODIC_LOST) p->Lost++;
+    if (kind & PERIODIC_NESTED) p->Nested++;
+    sr = StartCritical();  // the ADC and Timer1A interrupts both write here
+    v = &Violations[ViolationPutI & (OS_VIOLATIONSIZE - 1)];
+    v->Seq = ViolationPutI;
+    v->Start = start;
+    v->Finish = finish;
+    v->Slot = slot;
+    v->Kind = kind;
+    ViolationPutI++;
+    EndCritical(sr);
+}
+
+// ******** OS_PeriodicRun ************
+// run a periodic task and update its statistics: release jitter, run
+// time and violations; called from the interrupt that releases it
+// input:  periodic slot
+// output: none
+void OS_PeriodicRun(int slot) {
+    PeriodicStatsType *p = &Periodic[slot];
+    unsigned long release = OS_Time();
+    unsigned long diff, jitter, exec;
+    uint8_t kind = 0;
+    if (p->Running) {  // its interrupt came back before the last run returned
+        PeriodicViolation(slot, PERIODIC_NESTED, release, release);
+        return;
+    }
+    if (p->Releases) {  // the first release has no interval to time
+        diff = OS_TimeDifference(p->LastRelease, release);
+        jitter = (diff > p->Period) ? diff - p->Period : p->Period - diff;
+        jitter = (jitter + 4) / 8;  // in 0.1 usec
+        if (jitter > p->MaxJitter) {
+            p->MaxJitter = jitter;
+        }
+        if (jitter >= OS_JITTERSIZE) {
+            jitter = OS_JITTERSIZE - 1;
+        }
+        p->Jitter[jitter]++;
+        if (diff >= 2 * p->Period) {
+            kind |= PERIODIC_LOST;  // at least one release was lost
+        }
+    }
+    p->LastRelease = release;
+    p->Releases++;
+    p->Running = 1;
+    (*p->Task)();
+    p->Running = 0;
+    p->LastFinish = OS_Time();
+    exec = OS_TimeDifference(release, p->LastFinish);
+    if (exec > p->MaxExec) {
+        p->MaxExec = exec;
+    }
+    if (exec >= p->Period) {
+        kind |= PERIODIC_LONGRUN;  // still running when the next release was due
+    }
+    if (kind) {
+        PeriodicViolation(slot, kind, release, p->LastFinish);
+    }
+}
+
+// ******** OS_PeriodicStats ************
+// input:  periodic slot, 0 to OS_MAXPERIODIC-1
+// output: the slot's statistics, 0 if the slot is not in use
+const PeriodicStatsType *OS_PeriodicStats(uint32_t slot) {
+    if (slot >= (uint32_t)NumPeriodic) {
+        return 0;
+    }
+    return &Periodic[slot];
+}
+
+// ******** OS_PeriodicReset ************
+// clear the statistics of every periodic task, one slot per critical
+// section; the next interval is not timed
+// input:  none
+// output: none
+void OS_PeriodicReset(void) {
+    int slot, i;
+    long sr;
+    for (slot = 0; slot < NumPeriodic; slot++) {
+        sr = StartCritical();
+        Periodic[slot].Releases = 0;
+        Periodic[slot].MaxJitter = 0;
+        Periodic[slot].MaxExec = 0;
+        Periodic[slot].Overruns = 0;
+        Periodic[slot].LongRuns = 0;
+        Periodic[slot].Lost = 0;
+        Periodic[slot].Nested = 0;
+        Periodic[slot].Overrun = 0;
+        for (i = 0; i < OS_JITTERSIZE; i++) {
+            Periodic[slot].Jitter[i] = 0;
+        }
+        EndCritical(sr);
+    }
+}
+
+// ******** OS_PeriodicViolations ************
+// copy the violation records from number *seq on, oldest first, skipping
+// records that were overwritten before they were read
+// input:  pointer to the Seq of the first record wanted, advanced past
+//         the records copied; buffer for the records, size of the buffer
+// output: number of records copied
+int OS_PeriodicViolations(unsigned long *seq, struct PeriodicViolation *buf, int max) {
+    int n = 0;
+    long sr;
+    sr = StartCritical();
+    if (ViolationPutI - *seq > OS_VIOLATIONSIZE) {
+        *seq = ViolationPutI - OS_VIOLATIONSIZE;  // oldest record still in the ring
+    }
+    while ((n < max) && (*seq != ViolationPutI)) {
+        buf[n++] = Violations[*seq & (OS_VIOLATIONSIZE - 1)];
+        (*seq)++;
+    }
+    EndCritical(sr);
+    return n;
+}
+
+// Kernel Trace ------------------------------------------------------------------------------
+
+#ifdef KERNEL_TRACE
+static struct TraceRecord TraceRing[TRACESIZE];
+static uint32_t volatile TracePutI;  // total records written
+static uint32_t TraceGetI;           // next record to read out
+static uint32_t volatile TraceOn = 1;
+
+// ******** OS_TraceEvent ************
+// record one event in the trace ring, overwriting the oldest record
+// callable from ISRs, use the OS_TRACE macro so the call compiles away
+// input:  TRACE_ event type, event argument
+// output: none
+void OS_TraceEvent(uint8_t type, uint32_t arg) {
+    struct TraceRecord *pt;
+    long sr;
+    if (!TraceOn) return;
+    sr = StartCritical();
+    pt = &TraceRing[TracePutI & (TRACESIZE - 1)];
+    pt->time = OS_Time();
+    pt->type = type;
+    pt->thread = RunPt ? RunPt->id : 0;
+    pt->arg = arg;
+    TracePutI++;
+    EndCritical(sr);
+}
+
+// ******** OS_TraceStop ************
+// freeze the trace ring so it can be read out
+// input:  none
+// output: none
+void OS_TraceStop(void) {
+    TraceOn = 0;
+    if (TracePutI - TraceGetI > TRACESIZE) {
+        TraceGetI = TracePutI - TRACESIZE;  // oldest record still in the ring
+    }
+}
+
+// ******** OS_TraceStart ************
+// empty the trace ring and start recording again
+// input:  none
+// output: none
+void OS_TraceStart(void) {
+    long sr;
+    sr = StartCritical();
+    TracePutI = TraceGetI = 0;
+    TraceOn = 1;
+    EndCritical(sr);
+}
+
+// ******** OS_TraceRead ************
+// remove the oldest records from a stopped trace ring
+// input:  buffer for the records, size of the buffer
+// output: number of records copied, 0 when the ring is empty
+int OS_TraceRead(struct TraceRecord *buf, int max) {
+    int n = 0;
+    while ((n < max) && (TraceGetI != TracePutI)) {
+        buf[n++] = TraceRing[TraceGetI & (TRACESIZE - 1)];
+        TraceGetI++;
+    }
+    return n;
+}
+#endif
+
 // Timing Functions ------------------------------------------------------------------------------
 
 // ******** OS_Time ************
@@ -456,7 +1222,7 @@ unsigned long OS_MsTime(void) { return MSTime; }
 
 // Timers ------------------------------------------------------------------------------
 
-void InitTimer1A(unsigned long period, uint32_t priority) {
+void InitTimer1A(uint32_t priority) {
     long sr;
     volatile unsigned long delay;
 
@@ -469,24 +1235,43 @@ void InitTimer1A(unsigned long period, uint32_t priority) {
     TIMER1_CTL_R &= ~TIMER_CTL_TAEN;  // 1) disable timer1A during setup
                                       // 2) configure for 32-bit timer mode
     TIMER1_CFG_R = TIMER_CFG_32_BIT_TIMER;
-    // 3) configure for periodic mode, default down-count settings
-    TIMER1_TAMR_R = TIMER_TAMR_TAMR_PERIOD;
-    TIMER1_TAILR_R = period - 1;  // 4) reload value
-                                  // 5) clear timer1A timeout flag
+    // 3) configure for one-shot mode, PeriodicArm loads and starts it
+    TIMER1_TAMR_R = TIMER_TAMR_TAMR_1_SHOT;
+    TIMER1_TAILR_R = TIMER_TAILR_M;  // 4) no release due yet
+                                     // 5) clear timer1A timeout flag
     TIMER1_ICR_R = TIMER_ICR_TATOCINT;
     TIMER1_IMR_R |= TIMER_IMR_TATOIM;  // 6) arm timeout interrupt
                                        // 7) priority shifted to bits 15-13 for timer1A
     NVIC_PRI5_R = (NVIC_PRI5_R & 0xFFFF00FF) | (priority << 13);  // 3
     NVIC_EN0_R = NVIC_EN0_INT21;                                  // 8) enable interrupt 21 in NVIC
     TIMER1_TAPR_R = 0;
-    TIMER1_CTL_R |= TIMER_CTL_TAEN;  // 9) enable timer1A
 
     EndCritical(sr);
 }
 
+// run every periodic task that is due, then wait for the next release
+// a task that becomes due while another runs goes next if its period is
+// shorter, so the tasks run in rate monotonic order without preemption
 void Timer1A_Handler(void) {
+    PeriodicStatsType *p;
+    int i = 0;
+    OS_TRACE(TRACE_ISR_ENTER, TRACE_IRQ_TIMER1A);
     TIMER1_ICR_R = TIMER_ICR_TATOCINT;  // acknowledge timer1A timeout
-    (*PeriodicTask1)();
+    while (i < NumTimed) {
+        p = &Periodic[TimerOrder[i]];
+        if ((long)(p->Next - OS_Time()) > 0) {
+            i++;  // not due, try the next rate
+            continue;
+        }
+        OS_PeriodicRun(TimerOrder[i]);
+        p->Next += p->Period;
+        while ((long)(p->Next - OS_Time()) <= 0) {
+            p->Next += p->Period;  // a whole period behind, OS_PeriodicRun counts the lost release
+        }
+        i = 0;  // rescan from the shortest period
+    }
+    PeriodicArm();
+    OS_TRACE(TRACE_ISR_EXIT, TRACE_IRQ_TIMER1A);
 }
 
 void InitTimer2A(unsigned long period) {
@@ -518,9 +1303,11 @@ void InitTimer2A(unsigned long period) {
 
 void Timer2A_Handler(void) {
     int i;
+    OS_TRACE(TRACE_ISR_ENTER, TRACE_IRQ_TIMER2A);
 
     TIMER2_ICR_R = TIMER_ICR_TATOCINT;  // acknowledge timer2A timeout
     MSTime++;
+    TickTime++;
 
     for (i = 0; i < NUMTHREADS; i++) {
 #ifdef aging
@@ -541,6 +1328,8 @@ void Timer2A_Handler(void) {
         }
 #endif
     }
+    TimerTick();
+    OS_TRACE(TRACE_ISR_EXIT, TRACE_IRQ_TIMER2A);
 }
 
 void InitTimer3A(void) {
@@ -572,149 +1361,3 @@ void InitTimer3A(void) {
 void Timer3A_Handler(void) {
     TIMER3_ICR_R = TIMER_ICR_TATOCINT;  // acknowledge timer1A timeout
 }
-
-void InitTimer4A(uint32_t period, uint32_t priority) {
-    long sr;
-
-    sr = StartCritical();
-    SYSCTL_RCGCTIMER_R |= 0x10;
-
-    while ((SYSCTL_RCGCTIMER_R & 0x10) == 0) {
-    }  // allow time for clock to stabilize
-
-    TIMER4_CTL_R &= ~TIMER_CTL_TAEN;  // 1) disable timer4A during setup
-                                      // 2) configure for 32-bit timer mode
-    TIMER4_CFG_R = TIMER_CFG_32_BIT_TIMER;
-    // 3) configure for periodic mode, default down-count settings
-    TIMER4_TAMR_R = TIMER_TAMR_TAMR_PERIOD;
-    TIMER4_TAILR_R = period - 1;  // 4) reload value
-                                  // 5) clear timer4A timeout flag
-    TIMER4_ICR_R = TIMER_ICR_TATOCINT;
-    TIMER4_IMR_R |= TIMER_IMR_TATOIM;  // 6) arm timeout interrupt
-                                       // 7) priority shifted to bits 15-13 for timer1A
-    NVIC_PRI17_R = (NVIC_PRI17_R & 0xFF00FFFF) | (priority << 21);  // 3
-    NVIC_EN2_R = NVIC_EN2_INT70;  // 8) enable interrupt 70 in NVIC
-    TIMER4_TAPR_R = 0;
-    TIMER4_CTL_R |= TIMER_CTL_TAEN;  // 9) enable timer4A
-
-    EndCritical(sr);
-}
-
-void Timer4A_Handler(void) {
-    TIMER4_ICR_R = TIMER_ICR_TATOCINT;  // acknowledge timer4A timeout
-    (*PeriodicTask2)();
-}
-
-// Switch Tasks ------------------------------------------------------------------------
-
-#define BUTTON1 (*((volatile uint32_t *)0x40007100)) /* PD6 */
-#define BUTTON2 (*((volatile uint32_t *)0x40007200)) /* PD7 */
-volatile static uint32_t Last1, Last2;
-
-void ButtonOneInit(uint8_t priority) {
-    SYSCTL_RCGCGPIO_R |= 0x00000008;  // 1) activate clock for Port D
-    while ((SYSCTL_PRGPIO_R & 0x08) == 0) {
-    };                            // allow time for clock to stabilize
-                                  // 2) no need to unlock PD6
-    GPIO_PORTD_AMSEL_R &= ~0x40;  // 3) disable analog on PD6
-                                  // 4) configure PD6 as GPIO
-    GPIO_PORTD_PCTL_R = (GPIO_PORTD_PCTL_R & 0xF0FFFFFF) + 0x00000000;
-    GPIO_PORTD_DIR_R &= ~0x40;    // 5) make PD6 input
-    GPIO_PORTD_AFSEL_R &= ~0x40;  // 6) disable alt funct on PD6
-    GPIO_PORTD_DEN_R |= 0x40;     // 7) enable digital I/O on PD6
-    GPIO_PORTD_PUR_R |= 0x40;     //     enable weak pull-up on PD6
-    GPIO_PORTD_IS_R &= ~0x40;     // (d) PD6 is edge-sensitive
-    GPIO_PORTD_IBE_R |= 0x40;     //     PD6 is both edges
-    GPIO_PORTD_ICR_R = 0x40;      // (e) clear flag6
-    GPIO_PORTD_IM_R |= 0x40;  // (f) arm interrupt on PD6 *** No IME bit as mentioned in Book ***
-
-    NVIC_PRI0_R = (NVIC_PRI0_R & 0x1FFFFFFF) | (priority << 29);  // (g) priority 2
-    NVIC_EN0_R = 0x00000008;                                      // (h) enable interrupt 3 in NVIC
-    Last1 = BUTTON1;
-}
-
-void ButtonTwoInit(uint8_t priority) {
-    SYSCTL_RCGCGPIO_R |= 0x00000008;  // 1) activate clock for Port D
-    while ((SYSCTL_PRGPIO_R & 0x08) == 0) {
-    };                               // allow time for clock to stabilize
-    GPIO_PORTD_LOCK_R = 0x4C4F434B;  // 2) unlock GPIO Port D
-    GPIO_PORTD_CR_R = 0xFF;          // allow changes to PD7-0
-    GPIO_PORTD_AMSEL_R &= ~0x80;     // 3) disable analog on PD7
-                                     // 4) configure PD7 as GPIO
-    GPIO_PORTD_PCTL_R = (GPIO_PORTD_PCTL_R & 0x0FFFFFFF) + 0x00000000;
-    GPIO_PORTD_DIR_R &= ~0x80;    // 5) make PD6 input
-    GPIO_PORTD_AFSEL_R &= ~0x80;  // 6) disable alt funct on PD7
-    GPIO_PORTD_DEN_R |= 0x80;     // 7) enable digital I/O on PD7
-    GPIO_PORTD_PUR_R |= 0x80;     //     enable weak pull-up on PD7
-    GPIO_PORTD_IS_R &= ~0x80;     // (d) PD6 is edge-sensitive
-    GPIO_PORTD_IBE_R |= 0x80;     //     PD6 is both edges
-    GPIO_PORTD_ICR_R = 0x80;      // (e) clear flag7
-    GPIO_PORTD_IM_R |= 0x80;  // (f) arm interrupt on PD7 *** No IME bit as mentioned in Book ***
-
-    NVIC_PRI0_R = (NVIC_PRI0_R & 0x1FFFFFFF) | (priority << 29);  // (g) priority 2
-    NVIC_EN0_R = 0x00000008;                                      // (h) enable interrupt 3 in NVIC
-    Last2 = BUTTON2;
-}
-
-void static DebouncePD6(void) {
-    OS_Sleep(10);  // foreground sleep, must run within 5ms
-    Last1 = BUTTON1;
-    GPIO_PORTD_ICR_R = 0x40;
-    GPIO_PORTD_IM_R |= 0x40;
-    OS_Kill();
-}
-
-void static DebouncePD7(void) {
-    OS_Sleep(10);  // foreground sleep, must run within 5ms
-    Last2 = BUTTON2;
-    GPIO_PORTD_ICR_R = 0x80;
-    GPIO_PORTD_IM_R |= 0x80;
-    OS_Kill();
-}
-
-void GPIOPortD_Handler(void) {  // called on touch of either SW1 or SW2
-
-    if (GPIO_PORTD_RIS_R & 0x40) {  // BUTTON1 touched
-        GPIO_PORTD_IM_R &= ~0x40;   // disarm interrupt on PD6
-        if (Last1) {
-            (*ButtonOneTask)();
-        }
-        OS_AddThread(DebouncePD6, 128, 2);
-    } else if (GPIO_PORTD_RIS_R & 0x80) {  // BUTTON2 touched
-        GPIO_PORTD_IM_R &= ~0x80;          // disarm interrupt on PD7
-        if (Last2) {
-            (*ButtonTwoTask)();
-        }
-        OS_AddThread(DebouncePD7, 128, 2);
-    }
-}
-
-//******** OS_AddSW1Task ***************
-// add a background task to run whenever the BUTTON1 (PD6) button is pushed
-// Inputs: pointer to a void/void background function
-//         priority 0 is the highest, 5 is the lowest
-// Outputs: 1 if successful, 0 if this thread can not be added
-// It is assumed that the user task will run to completion and return
-// This task can not spin, block, loop, sleep, or kill
-// This task can call OS_Signal  OS_bSignal	 OS_AddThread
-// This task does not have a Thread ID
-int OS_AddSW1Task(void (*task)(void), unsigned long priority) {
-    ButtonOneTask = task;
-    ButtonOneInit(priority);
-    return 1;
-}
-
-//******** OS_AddSW2Task ***************
-// add a background task to run whenever the BUTTON2 (PD7) button is pushed
-// Inputs: pointer to a void/void background function
-//         priority 0 is highest, 5 is lowest
-// Outputs: 1 if successful, 0 if this thread can not be added
-// It is assumed user task will run to completion and return
-// This task can not spin block loop sleep or kill
-// This task can call issue OS_Signal, it can call OS_AddThread
-// This task does not have a Thread ID
-int OS_AddSW2Task(void (*task)(void), unsigned long priority) {
-    ButtonTwoTask = task;
-    ButtonTwoInit(priority);
-    return 1;
-}
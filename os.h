@@ -23,10 +23,10 @@
 
 #define NVIC_EN0_INT21 0x00200000  // Interrupt 21 enable
 #define NVIC_EN1_INT35 0x00000008
-#define NVIC_EN2_INT70 0x00000040
 
 #define TIMER_CFG_32_BIT_TIMER 0x00000000  // 32-bit timer configuration
 #define TIMER_TAMR_TACDIR 0x00000010       // GPTM Timer A Count Direction
+#define TIMER_TAMR_TAMR_1_SHOT 0x00000001  // One-Shot Timer mode
 #define TIMER_TAMR_TAMR_PERIOD 0x00000002  // Periodic Timer mode
 #define TIMER_CTL_TAEN 0x00000001          // GPTM TimerA Enable
 #define TIMER_IMR_TATOIM \
@@ -47,6 +47,43 @@
 #define TIME_500US (TIME_1MS / 2)
 #define TIME_250US (TIME_1MS / 5)
 
+#define NUMTHREADS 20  // Maximum number of threads
+
+// Kernel event tracer
+// Off by default so the trace points cost nothing; uncomment KERNEL_TRACE
+// to record them and add the trace shell command
+// #define KERNEL_TRACE
+#define TRACESIZE 512  // records kept, must be a power of 2
+
+// trace event types
+#define TRACE_SWITCH 1     // arg = thread id switched to
+#define TRACE_WAIT 2       // arg = semaphore address
+#define TRACE_SIGNAL 3     // arg = semaphore address
+#define TRACE_BLOCK 4      // arg = semaphore address, caller has to wait
+#define TRACE_ISR_ENTER 5  // arg = interrupt number
+#define TRACE_ISR_EXIT 6   // arg = interrupt number
+#define TRACE_CREATE 7     // arg = new thread id
+#define TRACE_KILL 8       // arg = killed thread id
+
+// interrupt numbers used as TRACE_ISR_ arguments
+#define TRACE_IRQ_UART0 5
+#define TRACE_IRQ_ADC0SS1 15
+#define TRACE_IRQ_TIMER1A 21
+#define TRACE_IRQ_TIMER2A 23
+
+struct TraceRecord {
+    uint32_t time;   // OS_Time() when the event happened
+    uint8_t type;    // TRACE_ event type
+    uint8_t thread;  // id of the thread running at the time
+    uint32_t arg;
+};
+
+#ifdef KERNEL_TRACE
+#define OS_TRACE(type, arg) OS_TraceEvent((type), (uint32_t)(arg))
+#else
+#define OS_TRACE(type, arg)
+#endif
+
 // feel free to change the type of semaphore, there are lots of good solutions
 struct Sema4 {
     long Value;  // >0 means free, otherwise means busy
@@ -75,6 +112,7 @@ void OS_Wait(Sema4Type *semaPt);
 
 // ******** OS_Signal ************
 // increment semaphore
+// enables interrupts on return, whatever they were on entry
 // input:  pointer to a counting semaphore
 // output: none
 void OS_Signal(Sema4Type *semaPt);
@@ -89,11 +127,96 @@ void OS_bWait(Sema4Type *semaPt);
 // output: none
 void OS_bSignal(Sema4Type *semaPt);
 
+// number of OS_Wait, OS_Signal, OS_bWait and OS_bSignal calls since boot
+extern unsigned long OS_SemaphoreOps;
+
+// event flag group, 32 independent bits that threads can wait on
+// setting bits wakes only the threads whose wait condition became true
+struct Flags {
+    unsigned long Value;  // currently set bits
+    Sema4Type Gate;       // what waiters block on when blockSema is defined
+};
+typedef struct Flags FlagsType;
+
+// OS_FlagsWait modes
+#define OS_FLAGS_ANY 0    // wake when any of the bits is set
+#define OS_FLAGS_ALL 1    // wake when all of the bits are set
+#define OS_FLAGS_CLEAR 2  // or'ed in, clear the bits that satisfied the wait
+
+// ******** OS_FlagsInit ************
+// initialize an event flag group
+// input:  pointer to a flag group, initial bits
+// output: none
+void OS_FlagsInit(FlagsType *flagsPt, unsigned long value);
+
+// ******** OS_FlagsSet ************
+// set bits and wake the threads waiting for them
+// can be called from an ISR
+// input:  pointer to a flag group, bits to set
+// output: none
+void OS_FlagsSet(FlagsType *flagsPt, unsigned long bits);
+
+// ******** OS_FlagsClear ************
+// clear bits, never wakes anybody
+// input:  pointer to a flag group, bits to clear
+// output: none
+void OS_FlagsClear(FlagsType *flagsPt, unsigned long bits);
+
+// ******** OS_FlagsPeek ************
+// read the bits without waiting
+// input:  pointer to a flag group
+// output: currently set bits
+#define OS_FlagsPeek(flagsPt) ((flagsPt)->Value)
+
+// ******** OS_FlagsWait ************
+// wait until any or all of the bits are set
+// input:  pointer to a flag group, bits to wait for,
+//         OS_FLAGS_ANY or OS_FLAGS_ALL, optionally or'ed with OS_FLAGS_CLEAR
+// output: the waited for bits that were set when the thread woke up
+unsigned long OS_FlagsWait(FlagsType *flagsPt, unsigned long bits, int mode);
+
+// reusable barrier, every participant waits until all of them have arrived
+// Phase counts releases, a waiter sleeps until it changes, so one release
+// wakes every waiter at once and the barrier is ready for the next round
+struct Barrier {
+    long Count;           // number of participants
+    long Arrived;         // participants waiting in the current phase
+    unsigned long Phase;  // incremented on every release
+    Sema4Type Gate;       // what waiters block on when blockSema is defined
+};
+typedef struct Barrier BarrierType;
+
+// ******** OS_BarrierInit ************
+// initialize a barrier
+// input:  pointer to a barrier, number of participants
+// output: none
+void OS_BarrierInit(BarrierType *barPt, long count);
+
+// ******** OS_BarrierWait ************
+// arrive at the barrier and wait until every participant has arrived
+// input:  pointer to a barrier
+// output: 1 for the participant that completed the phase, 0 for the others
+int OS_BarrierWait(BarrierType *barPt);
+
+// ******** OS_BarrierJoin ************
+// add one participant, takes part from the current phase on
+// input:  pointer to a barrier
+// output: none
+void OS_BarrierJoin(BarrierType *barPt);
+
+// ******** OS_BarrierLeave ************
+// remove one participant without arriving, releases the others
+// if they were only waiting for this one
+// input:  pointer to a barrier
+// output: none
+void OS_BarrierLeave(BarrierType *barPt);
+
 //******** OS_AddThread ***************
 // add a foregound thread to the scheduler
 // Inputs: pointer to a void/void foreground task
 //         number of bytes allocated for its stack
 //         priority, 0 is highest, 5 is the lowest
+//         0 is meant for the kernel's own threads, edfSched runs them first
 // Outputs: 1 if successful, 0 if this thread can not be added
 // stack size must be divisable by 8 (aligned to double word boundary)
 int OS_AddThread(void (*task)(void), unsigned long stackSize, unsigned long priority);
@@ -104,6 +227,22 @@ int OS_AddThread(void (*task)(void), unsigned long stackSize, unsigned long prio
 // Outputs: Thread ID, number greater than zero
 unsigned long OS_Id(void);
 
+//******** OS_ThreadStats ***************
+// reads the statistics kept in one TCB
+// Inputs: TCB slot, 0 to NUMTHREADS-1
+//         pointers to store the thread ID, the number of times the thread
+//         was switched to and its wait time before first running in ms
+// Outputs: 1 if the slot holds a live thread, 0 otherwise
+int OS_ThreadStats(uint32_t slot, uint32_t *id, uint32_t *execCount, uint32_t *waitTime);
+
+//******** OS_ThreadDeadlines ***************
+// reads the deadline accounting kept in one TCB, see OS_SetPeriod
+// Inputs: TCB slot, 0 to NUMTHREADS-1
+//         pointers to store the period in ms (0 if the thread is not periodic),
+//         the jobs it finished and how many of them missed their deadline
+// Outputs: 1 if the slot holds a live thread, 0 otherwise
+int OS_ThreadDeadlines(uint32_t slot, uint32_t *period, uint32_t *jobs, uint32_t *misses);
+
 //******** OS_AddPeriodicThread ***************
 // add a background periodic task
 // typically this function receives the highest priority
@@ -111,34 +250,154 @@ unsigned long OS_Id(void);
 //         period given in system time units (12.5ns)
 //         priority 0 is the highest, 5 is the lowest
 // Outputs: 1 if successful, 0 if this thread can not be added
-// You are free to select the time resolution for this function
+// Up to OS_MAXPERIODIC tasks share Timer1A, which is loaded with the time
+// to the next release and runs at the highest priority any task asked for.
+// Tasks due together run in rate monotonic order, shortest period first.
 // It is assumed that the user task will run to completion and return
 // This task can not spin, block, loop, sleep, or kill
 // This task can call OS_Signal  OS_bSignal	 OS_AddThread
 // This task does not have a Thread ID
 int OS_AddPeriodicThread(void (*task)(void), unsigned long period, unsigned long priority);
 
-//******** OS_AddSW1Task ***************
-// add a background task to run whenever the BUTTON1 (PD6) button is pushed
-// Inputs: pointer to a void/void background function
-//         priority 0 is the highest, 5 is the lowest
-// Outputs: 1 if successful, 0 if this thread can not be added
-// It is assumed that the user task will run to completion and return
-// This task can not spin, block, loop, sleep, or kill
-// This task can call OS_Signal  OS_bSignal	 OS_AddThread
-// This task does not have a Thread ID
-int OS_AddSW1Task(void (*task)(void), unsigned long priority);
+// Periodic task statistics
+// Every periodic task runs through OS_PeriodicRun, whether a timer of
+// OS_AddPeriodicThread releases it or a driver interrupt registered
+// with OS_AddPeriodicSource does, and the OS keeps its release jitter,
+// execution time and overruns.  Jitter is how far each interval
+// between releases is from the period.  An overrun is a run that
+// lasted a period or more, a release that came a period or more late
+// (the releases in between were lost), or a nested release: the task
+// released again before its previous run returned, which is dropped
+// since tasks are not reentrant.  Each overrun is also written to a
+// ring of the last OS_VIOLATIONSIZE violation records.
+#define OS_MAXPERIODIC 8    // periodic threads plus driver interrupts
+#define OS_JITTERSIZE 64    // jitter histogram bins of 0.1 us, the last one collects the rest
+#define PERIODIC_MINWAIT 80  // shortest Timer1A load, 1 us, for releases already due
+#define OS_VIOLATIONSIZE 16  // violation records kept, a power of 2
+
+// violation kinds, one record can have several
+#define PERIODIC_LONGRUN 0x01  // ran a period or longer
+#define PERIODIC_LOST 0x02     // released a period or more late
+#define PERIODIC_NESTED 0x04   // released while still running, the release was dropped
 
-//******** OS_AddSW2Task ***************
-// add a background task to run whenever the BUTTON2 (PD7) button is pushed
+struct PeriodicStats {
+    void (*Task)(void);
+    unsigned long Period;       // in 12.5 ns units
+    unsigned long Releases;     // times the task ran
+    unsigned long LastRelease;  // OS_Time at the latest release
+    unsigned long MaxJitter;    // in 0.1 us
+    unsigned long MaxExec;      // longest run in 12.5 ns units
+    unsigned long Overruns;     // violations of every kind
+    unsigned long LongRuns;     // PERIODIC_LONGRUN violations
+    unsigned long Lost;         // PERIODIC_LOST violations
+    unsigned long Nested;       // PERIODIC_NESTED violations
+    unsigned long LastFinish;   // OS_Time the latest run returned
+    unsigned long Next;  // next release for OS_AddPeriodicThread tasks, OS_Time units
+    uint8_t Overrun;     // set by the first overrun, cleared by OS_PeriodicReset
+    uint8_t Running;     // set while the task runs
+    unsigned long Jitter[OS_JITTERSIZE];
+};
+typedef struct PeriodicStats PeriodicStatsType;
+
+struct PeriodicViolation {
+    unsigned long Seq;     // violations recorded before this one since boot
+    unsigned long Start;   // OS_Time the run started
+    unsigned long Finish;  // OS_Time it returned, Start for a dropped nested release
+    uint8_t Slot;          // periodic slot
+    uint8_t Kind;          // PERIODIC_ bits
+};
+
+//******** OS_AddPeriodicSource ***************
+// register a periodic task that a driver interrupt releases
+// the driver calls OS_PeriodicRun with the returned slot instead of the task
 // Inputs: pointer to a void/void background function
-//         priority 0 is highest, 5 is lowest
-// Outputs: 1 if successful, 0 if this thread can not be added
-// It is assumed user task will run to completion and return
-// This task can not spin block loop sleep or kill
-// This task can call issue OS_Signal, it can call OS_AddThread
-// This task does not have a Thread ID
-int OS_AddSW2Task(void (*task)(void), unsigned long priority);
+//         period given in system time units (12.5ns)
+// Outputs: periodic slot, or -1 if all OS_MAXPERIODIC are taken
+int OS_AddPeriodicSource(void (*task)(void), unsigned long period);
+
+//******** OS_PeriodicRun ***************
+// run a periodic task and update its statistics
+// called from the interrupt that releases it
+// Inputs: periodic slot
+// Outputs: none
+void OS_PeriodicRun(int slot);
+
+//******** OS_PeriodicStats ***************
+// Inputs: periodic slot, 0 to OS_MAXPERIODIC-1
+// Outputs: the slot's statistics, 0 if the slot is not in use
+const PeriodicStatsType *OS_PeriodicStats(uint32_t slot);
+
+//******** OS_PeriodicReset ***************
+// clear the statistics of every periodic task, the next interval is not timed
+// Inputs: none
+// Outputs: none
+void OS_PeriodicReset(void);
+
+//******** OS_PeriodicViolations ***************
+// copy the violation records from number *seq on, oldest first
+// records overwritten before they were read are skipped, the gap shows in Seq
+// OS_PeriodicReset does not empty the ring
+// Inputs: pointer to the Seq of the first record wanted, 0 for every record
+//         still in the ring, advanced past the records copied
+//         buffer for the records, size of the buffer
+// Outputs: number of records copied
+int OS_PeriodicViolations(unsigned long *seq, struct PeriodicViolation *buf, int max);
+
+// software timer, counted down by the 1 ms tick and handled by the timer
+// daemon thread, so an expiring timer costs no thread of its own
+struct OSTimer {
+    void (*Task)(void);                 // callback, runs in the timer daemon thread
+    unsigned long Period;               // ms between callbacks, 0 for a one-shot
+    unsigned long volatile Remaining;   // ms until it expires
+    unsigned long volatile Active;      // 1 while counting down
+    unsigned long volatile Pending;     // expired, callback not run yet
+    struct OSTimer *Next;               // every created timer
+};
+typedef struct OSTimer OSTimerType;
+
+// ******** OS_TimerCreate ************
+// register a stopped software timer, call once per timer
+// input:  pointer to a timer, callback, period in ms or 0 for a one-shot
+// output: none
+// The callback runs in the timer daemon thread, it should be short
+// and must not sleep or wait on the timer it belongs to
+void OS_TimerCreate(OSTimerType *timerPt, void (*task)(void), unsigned long period);
+
+// ******** OS_TimerStart ************
+// start a stopped timer, does nothing if it is already running
+// input:  pointer to a timer, ms until the first callback (at least 1)
+// output: none
+void OS_TimerStart(OSTimerType *timerPt, unsigned long delay);
+
+// ******** OS_TimerRestart ************
+// (re)start a timer from now, dropping an expiry not yet handled
+// input:  pointer to a timer, ms until the first callback (at least 1)
+// output: none
+void OS_TimerRestart(OSTimerType *timerPt, unsigned long delay);
+
+// ******** OS_TimerCancel ************
+// stop a timer, its callback will not run until it is started again
+// input:  pointer to a timer
+// output: none
+void OS_TimerCancel(OSTimerType *timerPt);
+
+// deferred work, the bottom half of an interrupt
+// An ISR hands the slow part of its job to OS_Defer, which only copies a
+// function pointer and argument into a fixed ring, and the OS worker
+// thread (priority 0, created by OS_Init) runs it in thread context,
+// where it may block, sleep, call OS_Suspend or add threads.  Work runs
+// in the order it was deferred.
+#define OS_DEFERSIZE 16  // work items waiting for the worker, a power of 2
+
+// work dropped because the ring was full
+extern unsigned long OS_DeferDropped;
+
+// ******** OS_Defer ************
+// queue a function for the worker thread, callable from ISRs and from
+// inside critical sections, it leaves the interrupt state as it was
+// input:  function to run, argument to pass it
+// output: 1 if queued, 0 if the ring was full
+int OS_Defer(void (*task)(uint32_t arg), uint32_t arg);
 
 // ******** OS_Sleep ************
 // place this thread into a dormant state
@@ -148,6 +407,28 @@ int OS_AddSW2Task(void (*task)(void), unsigned long priority);
 // OS_Sleep(0) implements cooperative multitasking
 void OS_Sleep(unsigned long sleepTime);
 
+// ******** OS_SetPeriod ************
+// make the running thread periodic: it releases a job every period ms, and
+// each job has to reach OS_WaitNextPeriod within deadline ms of its release
+// The first call releases the first job now, later calls change the period
+// and deadline from the next release on.  Deadline misses are counted in
+// every scheduling mode; with edfSched defined in os.c the scheduler runs
+// the kernel threads added at priority 0 (TimerDaemon, DeferWorker) first,
+// then the ready periodic thread with the earliest absolute deadline, and
+// threads that never call this only when no periodic thread is ready.
+// edfSched needs blockSema, as prioritySched does.
+// input:  ms between releases, 0 to stop being periodic
+//         ms after each release its job has to finish in
+// output: none
+void OS_SetPeriod(unsigned long period, unsigned long deadline);
+
+// ******** OS_WaitNextPeriod ************
+// end the running thread's current job and sleep until its next release,
+// called by a thread after OS_SetPeriod in place of OS_Sleep
+// input:  none
+// output: none
+void OS_WaitNextPeriod(void);
+
 // ******** OS_Kill ************
 // kill the currently running thread, release its TCB and stack
 // input:  none
@@ -204,10 +485,45 @@ unsigned long OS_MsTime(void);
 // It is ok to limit the range of theTimeSlice to match the 24-bit SysTick
 void OS_Launch(unsigned long theTimeSlice);
 
+// ******** OS_SetTimeSlice ************
+// change the time slice while running, takes effect on the next SysTick reload
+// Inputs: number of 12.5ns clock cycles for each time slice (maximum of 24 bits)
+// Outputs: none
+void OS_SetTimeSlice(unsigned long theTimeSlice);
+
+// ******** OS_TimeSlice ************
+// Inputs: none
+// Outputs: number of 12.5ns clock cycles for each time slice
+unsigned long OS_TimeSlice(void);
+
+// ******** OS_TraceEvent ************
+// record one event in the trace ring, overwriting the oldest record
+// callable from ISRs, use the OS_TRACE macro so the call compiles away
+// input:  TRACE_ event type, event argument
+// output: none
+void OS_TraceEvent(uint8_t type, uint32_t arg);
+
+// ******** OS_TraceStop ************
+// freeze the trace ring so it can be read out
+// input:  none
+// output: none
+void OS_TraceStop(void);
+
+// ******** OS_TraceStart ************
+// empty the trace ring and start recording again
+// input:  none
+// output: none
+void OS_TraceStart(void);
+
+// ******** OS_TraceRead ************
+// remove the oldest records from a stopped trace ring
+// input:  buffer for the records, size of the buffer
+// output: number of records copied, 0 when the ring is empty
+int OS_TraceRead(struct TraceRecord *buf, int max);
+
 void Scheduler(void);
-void InitTimer1A(unsigned long period, uint32_t priority);
+void InitTimer1A(uint32_t priority);
 void InitTimer2A(unsigned long period);
 void InitTimer3A(void);
-void InitTimer4A(uint32_t period, uint32_t priority);
 
 #endif
@@ -0,0 +1 @@
+#include "../../os.h"
@@ -0,0 +1,287 @@
+// hostsim.c
+// Runs on Linux
+// Headless benchmark of the whole game: Main.c runs unchanged on the
+// simulated OS and hardware (simos.c, simhw.c) with scripted input, and
+// the cube steps per host second, semaphore calls per step and LCD
+// calls per step are reported when the requested number of steps is done.
+//
+// usage: hostsim [-n steps] [-t step ms] [-c cubes] [-s script | -a] [-p rr|prio|edf] [-j]
+//        hostsim -b participants
+//   -n  cube steps to run, default 10000
+//   -t  ms between cube steps (SleepTime in Main.c), default unchanged
+//   -c  cubes in the first wave (CubesPerWave in Main.c), default unchanged
+//   -s  input script, one event per line, times in simulated ms:
+//         <ms> stick <x> <y> [select]   joystick ADC values from then on
+//         <ms> button <1|2>             press SW1 or SW2
+//       without a script the stick sweeps the screen and SW2 is pressed
+//       after every game over, so the game keeps restarting
+//   -a  let the autoplay bot (AutoPlay.c) play instead
+//   -p  scheduling policy: round robin (default), fixed priority, or
+//       earliest deadline first for the threads that call OS_SetPeriod
+//   -j  the joystick ISR starts the conversion and waits SIM_ADC_CYCLES
+//       for it, as before Timer0A triggered the ADC, to compare the
+//       periodic max exec and jitter
+//   -b  skip the game and run the barrier benchmark in Main.c
+//       (BarrierRoundTrip) for 1 up to the given number of participants;
+//       every count reports the simulated us and host ns per round trip
+// The report is one "name value" pair per line.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "os.h"
+#include "AutoPlay.h"
+#include "Hist.h"
+#include "sim.h"
+
+#define SIM_GAME_OVER 0x01    // GAME_OVER in Main.c
+#define SIM_STALL 60000       // simulated ms without a cube step that counts as a hang
+#define SIM_RESTARTDELAY 200  // ms between game over and the scripted SW2 press
+#define SIM_MAXEVENTS 4096
+#define SIM_BARRIERROUNDS 1000  // BARRIER_ROUNDS in Main.c
+
+int Game_Main(void);  // main() in Main.c, renamed by the Makefile
+extern unsigned long StepCount;
+extern unsigned long SleepTime;
+extern uint32_t CubesPerWave;
+extern FlagsType GameFlags;
+extern unsigned long SimUartBytes;
+unsigned long BarrierRoundTrip(long participants, unsigned long priority);
+
+static unsigned long TargetSteps = 10000;
+static struct timespec HostStart;
+static unsigned long Games = 1;
+static int Bot;  // turn the autoplay bot on at the first tick
+
+static struct {
+    uint32_t ms;
+    int button;  // 0 for a stick event
+    uint16_t x, y;
+    uint8_t select;
+} Script[SIM_MAXEVENTS];
+static int ScriptSize, ScriptI, Scripted;
+
+static long BarrierMax;  // -b, 0 to run the game
+static int BarrierDone;
+static double BarrierSimUs[NUMTHREADS + 1], BarrierHostNs[NUMTHREADS + 1];
+
+static uint16_t StickX = 2048, StickY = 2048;
+static uint8_t StickSelect = 1;  // 0 when pressed
+
+static void ReadScript(const char *name) {
+    FILE *f = fopen(name, "r");
+    char line[128], kind[16];
+    unsigned ms, a, b, c;
+    int n;
+    if (f == 0) {
+        perror(name);
+        exit(1);
+    }
+    while (fgets(line, sizeof(line), f) && ScriptSize < SIM_MAXEVENTS) {
+        if (line[0] == '#') continue;
+        n = sscanf(line, "%u %15s %u %u %u", &ms, kind, &a, &b, &c);
+        if (n >= 4 && strcmp(kind, "stick") == 0) {
+            Script[ScriptSize].ms = ms;
+            Script[ScriptSize].button = 0;
+            Script[ScriptSize].x = a;
+            Script[ScriptSize].y = b;
+            Script[ScriptSize].select = (n == 5) ? c : 1;
+            ScriptSize++;
+        } else if (n >= 3 && strcmp(kind, "button") == 0) {
+            Script[ScriptSize].ms = ms;
+            Script[ScriptSize].button = a;
+            ScriptSize++;
+        }
+    }
+    fclose(f);
+    Scripted = 1;
+}
+
+// triangle wave from -amp to amp with the given period in ms
+static int Triangle(uint32_t ms, uint32_t period, int amp) {
+    uint32_t phase = ms % period;
+    uint32_t v = (phase < period / 2) ? phase : period - phase;
+    return (int)(4 * v * (uint32_t)amp / period) - amp;
+}
+
+int SimScript_Tick(uint32_t ms) {
+    static uint32_t overSince;
+    int pressed = 0;
+    if (BarrierMax) return 0;  // no game running
+    if (Bot) {  // main() in Main.c has run AutoPlay_Init by now
+        AutoPlay_Enable(1);
+        Bot = 0;
+    }
+    if (Scripted) {
+        while (ScriptI < ScriptSize && Script[ScriptI].ms <= ms) {
+            if (Script[ScriptI].button) {
+                SimPress(Script[ScriptI].button);
+                pressed = 1;
+            } else {
+                StickX = Script[ScriptI].x;
+                StickY = Script[ScriptI].y;
+                StickSelect = Script[ScriptI].select;
+            }
+            ScriptI++;
+        }
+        return pressed;
+    }
+    if (AutoPlay_Enabled()) {
+        return 0;  // the bot steers and presses the buttons
+    }
+    StickX = 2048 + Triangle(ms, 3100, 1800);  // sweep the whole screen
+    StickY = 2048 + Triangle(ms, 4300, 1800);
+    if (OS_FlagsPeek(&GameFlags) & SIM_GAME_OVER) {
+        if (overSince == 0) {
+            overSince = ms;
+        } else if (ms - overSince == SIM_RESTARTDELAY) {
+            SimPress(2);
+            Games++;
+            pressed = 1;
+        }
+    } else {
+        overSince = 0;
+    }
+    return pressed;
+}
+
+void SimInput(uint16_t *x, uint16_t *y, uint8_t *select) {
+    *x = StickX;
+    *y = StickY;
+    *select = StickSelect;
+}
+
+int SimDone(void) {
+    static unsigned long lastSteps;
+    static uint64_t lastStepTime;
+    if (BarrierMax) return BarrierDone;
+    if (StepCount != lastSteps) {
+        lastSteps = StepCount;
+        lastStepTime = SimCycles;
+    } else if (SimCycles - lastStepTime > (uint64_t)SIM_STALL * TIME_1MS) {
+        fprintf(stderr, "hostsim: no cube step in %d simulated ms\n", SIM_STALL);
+        SimReport();
+        exit(2);
+    }
+    return StepCount >= TargetSteps;
+}
+
+void SimReport(void) {
+    struct timespec now;
+    double host, steps;
+    long n;
+    HistType *hist;
+    const PeriodicStatsType *periodic;
+    uint32_t slot, id, execCount, waitTime, period, jobs, misses;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    host = (now.tv_sec - HostStart.tv_sec) + (now.tv_nsec - HostStart.tv_nsec) / 1e9;
+    if (BarrierMax) {
+        for (n = 1; n <= BarrierMax; n++) {
+            printf("barrier%ld_round_us %.2f\n", n, BarrierSimUs[n]);
+            printf("barrier%ld_host_ns %.0f\n", n, BarrierHostNs[n]);
+        }
+        printf("host_s %.3f\n", host);
+        return;
+    }
+    steps = StepCount ? StepCount : 1;
+    printf("steps %lu\n", StepCount);
+    printf("games %lu\n", AutoPlay_Enabled() ? AutoPlay_Games + 1 : Games);
+    printf("simulated_s %.1f\n", SimCycles / 80e6);
+    printf("host_s %.3f\n", host);
+    printf("steps_per_s %.0f\n", host > 0 ? StepCount / host : 0);
+    printf("sema_ops_per_step %.2f\n", OS_SemaphoreOps / steps);
+    printf("draw_ops_per_step %.2f\n", SimDrawOps / steps);
+    printf("pixels_per_step %.0f\n", SimPixels / steps);
+    printf("switches_per_step %.2f\n", SimSwitches / steps);
+    printf("uart_bytes_per_step %.2f\n", SimUartBytes / steps);
+    printf("deadline_jobs %lu\n", SimJobs);
+    printf("deadline_misses %lu\n", SimMisses);
+    printf("deadline_miss_pct %.2f\n", SimJobs ? 100.0 * SimMisses / SimJobs : 0);
+    for (slot = 0; slot < NUMTHREADS; slot++) {  // live periodic threads
+        if (OS_ThreadStats(slot, &id, &execCount, &waitTime) &&
+            OS_ThreadDeadlines(slot, &period, &jobs, &misses) && period) {
+            printf("thread%u_period%u_misses %u/%u\n", id, period, misses, jobs);
+        }
+    }
+    for (slot = 0; (periodic = OS_PeriodicStats(slot)) != 0; slot++) {
+        printf("periodic%u_max_exec_us %lu\n", slot, periodic->MaxExec / 80);
+        printf("periodic%u_max_jitter_us %.1f\n", slot, periodic->MaxJitter / 10.0);
+        printf("periodic%u_overruns %lu\n", slot, periodic->Overruns);
+        printf("periodic%u_longruns %lu\n", slot, periodic->LongRuns);
+        printf("periodic%u_lost %lu\n", slot, periodic->Lost);
+        printf("periodic%u_nested %lu\n", slot, periodic->Nested);
+    }
+    for (hist = Hist_List; hist; hist = hist->Next) {  // simulated time, in us
+        printf("%s_p50_us %lu\n", hist->Name, Hist_Percentile(hist, 50) / 80);
+        printf("%s_p99_us %lu\n", hist->Name, Hist_Percentile(hist, 99) / 80);
+        printf("%s_max_us %lu\n", hist->Name, hist->Max / 80);
+    }
+}
+
+// the only thread with -b, times each participant count
+static void BarrierBench(void) {
+    struct timespec start, stop;
+    unsigned long elapsed;
+    long n;
+    for (n = 1; n <= BarrierMax; n++) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        elapsed = BarrierRoundTrip(n, 1);
+        clock_gettime(CLOCK_MONOTONIC, &stop);
+        if (elapsed == 0) {
+            fprintf(stderr, "hostsim: no thread slot for %ld participants\n", n);
+            exit(1);
+        }
+        BarrierSimUs[n] = elapsed / 80.0 / SIM_BARRIERROUNDS;
+        BarrierHostNs[n] = ((stop.tv_sec - start.tv_sec) * 1e9 +
+                            (stop.tv_nsec - start.tv_nsec)) / SIM_BARRIERROUNDS;
+    }
+    BarrierDone = 1;
+    OS_Sleep(1);
+}
+
+// SIM_ policy named on the command line, -1 if unknown
+static int Policy(const char *name) {
+    if (strcmp(name, "rr") == 0) return SIM_ROUNDROBIN;
+    if (strcmp(name, "prio") == 0) return SIM_PRIORITY;
+    if (strcmp(name, "edf") == 0) return SIM_EDF;
+    return -1;
+}
+
+int main(int argc, char *argv[]) {
+    int i;
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            TargetSteps = strtoul(argv[++i], 0, 0);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            SleepTime = strtoul(argv[++i], 0, 0);
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            CubesPerWave = strtoul(argv[++i], 0, 0);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            ReadScript(argv[++i]);
+        } else if (strcmp(argv[i], "-a") == 0) {
+            Bot = 1;
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc && Policy(argv[i + 1]) >= 0) {
+            SimPolicy = Policy(argv[++i]);
+        } else if (strcmp(argv[i], "-j") == 0) {
+            SimPolledAdc = 1;
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            BarrierMax = strtol(argv[++i], 0, 0);
+            if (BarrierMax < 1) BarrierMax = 1;
+            if (BarrierMax > NUMTHREADS) BarrierMax = NUMTHREADS;
+        } else {
+            fprintf(stderr, "usage: hostsim [-n steps] [-t step ms] [-c cubes] [-s script | -a]"
+                            " [-p rr|prio|edf] [-j]\n"
+                            "       hostsim -b participants\n");
+            return 1;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &HostStart);
+    if (BarrierMax) {
+        OS_Init();
+        OS_AddThread(&BarrierBench, 128, 1);
+        OS_Launch(TIME_2MS);  // reports and exits
+    }
+    return Game_Main();  // OS_Launch reports and exits
+}
@@ -0,0 +1,55 @@
+// sim.h
+// Runs on Linux
+// Glue between the simulated OS (simos.c), the simulated hardware
+// (simhw.c) and the benchmark driver (hostsim.c).
+
+#ifndef __SIM_H__
+#define __SIM_H__
+
+#include <stdint.h>
+
+// virtual time charged for things the host does much faster than the board
+#define SIM_SWITCH_CYCLES 400  // thread switch, 5 us
+#define SIM_CALL_CYCLES 80     // OS_Time or OS_MsTime, 1 us
+#define SIM_PIXEL_CYCLES 160   // one 16-bit pixel over 8 MHz SPI, 2 us
+#define SIM_ADC_CYCLES 20480   // joystick X and Y, 16 averaged conversions each at 125 ksps, 256 us
+
+extern uint64_t SimCycles;         // virtual time in 12.5 ns units
+extern unsigned long SimSwitches;  // thread switches
+extern unsigned long SimProgress;  // bumped by anything that can unblock a thread
+extern unsigned long SimDrawOps;   // BSP_LCD_ calls
+extern unsigned long SimPixels;    // pixels those calls covered
+extern int SimPolledAdc;           // 1 if the joystick ISR waits for its own conversion
+
+// how simos.c picks the next thread
+#define SIM_ROUNDROBIN 0  // the os.c default
+#define SIM_PRIORITY 1    // prioritySched, lowest OS_AddThread priority first
+#define SIM_EDF 2         // edfSched, earliest absolute deadline first
+extern int SimPolicy;
+extern unsigned long SimJobs;    // jobs finished with OS_WaitNextPeriod, by every thread
+extern unsigned long SimMisses;  // how many of them missed their deadline
+
+// advance virtual time, may switch threads at the end of a time slice
+void SimCharge(uint32_t cycles);
+
+// run task every period cycles between thread switches, like a timer ISR
+void SimAddPeriodic(void (*task)(void), uint32_t period);
+
+// hold SW1 (1) or SW2 (2) down for SIM_PRESSMS, Buttons.c debounces it
+#define SIM_PRESSMS 100
+void SimPress(int button);
+
+// scripted input, called every simulated ms from the tick
+// returns 1 if it pressed a button
+int SimScript_Tick(uint32_t ms);
+
+// the scripted joystick position, see hostsim.c
+void SimInput(uint16_t *x, uint16_t *y, uint8_t *select);
+
+// 1 once the requested number of steps has run
+int SimDone(void);
+
+// print the results
+void SimReport(void);
+
+#endif
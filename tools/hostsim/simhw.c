@@ -0,0 +1,148 @@
+// simhw.c
+// Runs on Linux
+// The board support the game calls, simulated for the host.
+// The LCD draws nothing but counts calls and pixels and charges their
+// SPI time; UART output is counted and dropped, UART input never comes;
+// the joystick reads the scripted position from hostsim.c, and with
+// SimPolledAdc its ISR spins through the conversion like the software
+// triggered sampling that Timer0A replaced; a pressed
+// switch reads as held for SIM_PRESSMS; the EEPROM is a RAM array; the
+// analog sampler is absent.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "os.h"
+#include "LCD.h"
+#include "UART.h"
+#include "joystick.h"
+#include "Sampler.h"
+#include "Switch.h"
+#include "driverlib/eeprom.h"
+#include "driverlib/sysctl.h"
+#include "sim.h"
+
+unsigned long SimDrawOps;
+unsigned long SimPixels;
+unsigned long SimUartBytes;
+
+// LCD ----------------------------------------------------------------------------------------
+
+Sema4Type LCDFree;
+
+static void Draw(uint32_t pixels) {
+    SimDrawOps++;
+    SimPixels += pixels;
+    SimProgress++;
+    SimCharge(pixels * SIM_PIXEL_CYCLES);
+}
+
+void BSP_LCD_OutputInit(void) { OS_InitSemaphore(&LCDFree, 1); }
+void BSP_LCD_FillScreen(uint16_t color) { Draw(128 * 128); }
+void BSP_LCD_FillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) { Draw(w * h); }
+void BSP_LCD_DrawBitmap(int16_t x, int16_t y, const uint16_t *image, int16_t w, int16_t h) {
+    Draw(w * h);
+}
+void BSP_LCD_DrawChar(int16_t x, int16_t y, char c, int16_t textColor, int16_t bgColor,
+                      uint8_t size) {
+    Draw(6 * 8 * size * size);
+}
+uint32_t BSP_LCD_DrawString(uint16_t x, uint16_t y, char *pt, int16_t textColor) {
+    uint32_t n = strlen(pt);
+    Draw(n * 6 * 8);
+    return n;
+}
+void BSP_LCD_Message(int device, int line, int col, char *string, unsigned int value) {
+    Draw((strlen(string) + 5) * 6 * 8);  // the label and up to 5 digits
+}
+void BSP_LCD_DrawCrosshair(int16_t x, int16_t y, int width, int16_t bgColor) {
+    Draw(4 * (2 * width + 1));  // two lines, two pixels wide
+}
+
+// UART ---------------------------------------------------------------------------------------
+
+void UART_Init(void) {}
+void UART_OutChar(char data) { SimUartBytes++; }
+void UART_OutString(char *pt) { SimUartBytes += strlen(pt); }
+void UART_OutUDec(uint32_t n) { SimUartBytes += 4; }
+void UART_OutUHex(uint32_t number) { SimUartBytes += 8; }
+void OutCRLF(void) { SimUartBytes += 2; }
+
+// nobody types at the simulated shell
+void UART_InString(char *bufPt, uint16_t max) {
+    while (1) {
+        OS_Sleep(1000000);
+    }
+}
+
+// Joystick -----------------------------------------------------------------------------------
+
+void BSP_Joystick_Init(void) {}
+
+void BSP_Joystick_Input(uint16_t *x, uint16_t *y, uint8_t *select) { SimInput(x, y, select); }
+
+int SimPolledAdc;
+static int JoystickSlot;
+static void (*JoystickTask)(void);
+
+static void JoystickIsr(void) { OS_PeriodicRun(JoystickSlot); }
+
+// start the conversion and spin until it is done, then run the task,
+// nothing else runs meanwhile
+static void PolledTask(void) {
+    SimCycles += SIM_ADC_CYCLES;
+    JoystickTask();
+}
+
+void BSP_Joystick_AddTask(void (*task)(void), uint32_t period, uint32_t priority) {
+    JoystickTask = task;
+    JoystickSlot = OS_AddPeriodicSource(SimPolledAdc ? &PolledTask : task, period);  // like joystick.c
+    SimAddPeriodic(&JoystickIsr, period);
+}
+
+void BSP_Joystick_Sample(uint16_t *x, uint16_t *y, uint8_t *select) { SimInput(x, y, select); }
+
+// Switches -----------------------------------------------------------------------------------
+
+static uint64_t PressedAt[2];  // SimCycles of the latest SimPress, 0 if never
+
+void SimPress(int button) {
+    PressedAt[button - 1] = SimCycles ? SimCycles : 1;
+}
+
+static int Held(int button) {
+    return PressedAt[button - 1] && SimCycles - PressedAt[button - 1] < SIM_PRESSMS * TIME_1MS;
+}
+
+void Switch_Init(void) {}
+int Switch_SW1(void) { return Held(1); }
+int Switch_SW2(void) { return Held(2); }
+
+// Sampler ------------------------------------------------------------------------------------
+
+unsigned long SamplerOverflow;
+void Sampler_Init(uint32_t priority) {}
+uint32_t Sampler_Blocks(void) { return 0; }
+uint16_t Sampler_Latest(uint32_t channel) { return 0; }
+
+// EEPROM and system control ------------------------------------------------------------------
+
+static uint32_t Eeprom[512];  // 2 KB like the TM4C123
+
+uint32_t EEPROMInit(void) { return EEPROM_INIT_OK; }
+
+void EEPROMRead(uint32_t *pui32Data, uint32_t ui32Address, uint32_t ui32Count) {
+    if (ui32Address + ui32Count <= sizeof(Eeprom)) {
+        memcpy(pui32Data, (uint8_t *)Eeprom + ui32Address, ui32Count);
+    }
+}
+
+uint32_t EEPROMProgram(uint32_t *pui32Data, uint32_t ui32Address, uint32_t ui32Count) {
+    if (ui32Address + ui32Count <= sizeof(Eeprom)) {
+        memcpy((uint8_t *)Eeprom + ui32Address, pui32Data, ui32Count);
+    }
+    return 0;
+}
+
+void SysCtlPeripheralEnable(uint32_t ui32Peripheral) {}
+void SysCtlDelay(uint32_t ui32Count) {}
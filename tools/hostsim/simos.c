@@ -0,0 +1,705 @@
+// simos.c
+// Runs on Linux
+// The os.h API on the host, for the headless game simulation.
+// Threads are ucontext coroutines switched by a cooperative scheduler,
+// and time is virtual: SimCycles counts 12.5 ns bus cycles like OS_Time
+// on the board.  Time advances when a thread switches, when it calls
+// into the simulated hardware (LCD drawing is charged per pixel), and
+// when every thread is waiting, in which case the clock jumps to the next
+// 1 ms tick or joystick sample that changes something.  The 1 ms tick
+// and the periodic tasks run between thread switches, and also inside
+// the time a thread is charged for (a full screen fill is 33 ms) when
+// they fall due there, the way an interrupt would.  A thread that keeps
+// the CPU past the end of its time slice is switched out there, or at its
+// next call into the OS or the simulated hardware.  Critical sections
+// hold off both.
+// Semaphores, flags and barriers park a waiting thread until its
+// condition holds instead of spinning, so idle time costs nothing.
+// SimPolicy picks the next thread like one of the os.c schedulers: round
+// robin, fixed priority, or earliest deadline first among the threads
+// that called OS_SetPeriod, so their deadline misses can be compared.
+// Since waiting threads are parked, every policy models a blockSema
+// build; os.c only allows prioritySched and edfSched with blockSema.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+#include "os.h"
+#include "sim.h"
+
+#define SIMSTACK (64 * 1024)  // bytes of host stack per thread
+#define SIMPERIODIC OS_MAXPERIODIC
+
+struct SimThread {
+    ucontext_t ctx;
+    void *stack;
+    void (*task)(void);
+    int used;
+    int dead;
+    uint32_t id;
+    uint32_t execCount;
+    uint32_t arriveTime;
+    uint32_t waitTime;
+    unsigned long priority;
+    uint32_t period;        // OS_SetPeriod, ms between releases, 0 if not periodic
+    uint32_t deadline;      // ms after a release the job has to finish in
+    uint32_t release;       // AbsMs the current job was released
+    uint32_t jobs;
+    uint32_t misses;
+    unsigned long sleepCt;  // ms left to sleep
+    int (*ready)(struct SimThread *t);  // 0 while parked, 0 pointer if runnable
+    void *waitOn;                       // what ready() looks at
+    unsigned long waitBits;
+    int waitMode;
+    unsigned long waitPhase;
+};
+
+static struct SimThread Threads[NUMTHREADS];
+static int Current = -1;  // running thread, -1 in the scheduler
+static ucontext_t SchedCtx;
+static uint32_t NumLive;
+int SimPolicy = SIM_ROUNDROBIN;
+unsigned long SimJobs;
+unsigned long SimMisses;
+
+uint64_t SimCycles;            // virtual time in 12.5 ns units
+unsigned long SimSwitches;     // thread switches
+unsigned long SimProgress;     // bumped by anything that can unblock a thread
+static uint64_t NextTick;      // cycle of the next 1 ms tick
+static uint64_t MsBase;        // OS_ClearMsTime
+static uint64_t SliceStart;    // cycle the running thread was switched in
+static unsigned long TimeSlice = TIME_2MS;
+static uint32_t AbsMs;         // ms ticks since boot, never cleared
+static int InIsr;              // running a periodic task or the script
+static long Critical;          // StartCritical nesting
+
+unsigned long OS_SemaphoreOps;
+
+static struct {
+    void (*task)(void);
+    int slot;  // OS periodic slot of an OS_AddPeriodicThread task, -1 to call task
+    uint64_t period;
+    uint64_t next;
+} Periodic[SIMPERIODIC];
+static int NumPeriodic;
+
+static OSTimerType *Timers;
+static int TimersPending;
+
+static struct {
+    void (*task)(uint32_t arg);
+    uint32_t arg;
+} DeferRing[OS_DEFERSIZE];
+static uint32_t DeferPutI, DeferGetI;
+unsigned long OS_DeferDropped;
+static void DeferWorker(void);
+static int Deliver(void);
+static uint64_t NextInterrupt(void);
+
+// switch back to the scheduler
+static void Yield(void) {
+    struct SimThread *t;
+    if (InIsr || Current < 0) return;
+    t = &Threads[Current];
+    swapcontext(&t->ctx, &SchedCtx);
+}
+
+// park the running thread until ready(t) is true
+static void WaitFor(int (*ready)(struct SimThread *t)) {
+    struct SimThread *t = &Threads[Current];
+    t->ready = ready;
+    while (!ready(t)) {
+        Yield();
+    }
+    t->ready = 0;
+}
+
+void SimCharge(uint32_t cycles) {
+    uint64_t next;
+    // interrupts that fall due on the way run on time, their own time
+    // pushes the rest of the work back, and the tick can end the slice;
+    // before OS_Launch (no thread running) interrupts are still disabled
+    while (Current >= 0 && !InIsr && !Critical && (next = NextInterrupt()) < SimCycles + cycles) {
+        if (next > SimCycles) {
+            cycles -= (uint32_t)(next - SimCycles);
+            SimCycles = next;
+        }
+        Deliver();
+        if (SimCycles - SliceStart >= TimeSlice) {
+            Yield();  // preempted, the rest of the work runs when it is back
+        }
+    }
+    SimCycles += cycles;
+    if (!InIsr && !Critical && Current >= 0 && SimCycles - SliceStart >= TimeSlice) {
+        Yield();  // preempted at the end of its slice
+    }
+}
+
+long StartCritical(void) { return Critical++; }
+void EndCritical(long sr) { Critical = sr; }
+void OS_DisableInterrupts(void) { Critical = 1; }
+void OS_EnableInterrupts(void) { Critical = 0; }
+
+// Threads ------------------------------------------------------------------------------------
+
+static void ThreadEntry(void) {
+    Threads[Current].task();
+    OS_Kill();  // fell off the end
+}
+
+void OS_Init(void) {
+    SimCycles = 0;
+    NextTick = TIME_1MS;
+    OS_AddThread(&DeferWorker, 128, 0);  // like os.c
+}
+
+int OS_AddThread(void (*task)(void), unsigned long stackSize, unsigned long priority) {
+    static uint32_t nextId;
+    int i;
+    for (i = 0; i < NUMTHREADS; i++) {
+        if (!Threads[i].used) break;
+    }
+    if (i == NUMTHREADS) return 0;
+    if (Threads[i].stack == 0) {
+        Threads[i].stack = malloc(SIMSTACK);
+        if (Threads[i].stack == 0) return 0;
+    }
+    getcontext(&Threads[i].ctx);
+    Threads[i].ctx.uc_stack.ss_sp = Threads[i].stack;
+    Threads[i].ctx.uc_stack.ss_size = SIMSTACK;
+    Threads[i].ctx.uc_link = 0;
+    makecontext(&Threads[i].ctx, ThreadEntry, 0);
+    Threads[i].task = task;
+    Threads[i].used = 1;
+    Threads[i].dead = 0;
+    Threads[i].id = nextId++;
+    Threads[i].execCount = 0;
+    Threads[i].arriveTime = (uint32_t)SimCycles;
+    Threads[i].waitTime = 0;
+    Threads[i].priority = priority;
+    Threads[i].period = 0;
+    Threads[i].jobs = 0;
+    Threads[i].misses = 0;
+    Threads[i].sleepCt = 0;
+    Threads[i].ready = 0;
+    NumLive++;
+    SimProgress++;
+    return 1;
+}
+
+unsigned long OS_Id(void) { return Current < 0 ? 0 : Threads[Current].id; }
+
+int OS_ThreadStats(uint32_t slot, uint32_t *id, uint32_t *execCount, uint32_t *waitTime) {
+    if (slot >= NUMTHREADS || !Threads[slot].used) return 0;
+    *id = Threads[slot].id;
+    *execCount = Threads[slot].execCount;
+    *waitTime = Threads[slot].waitTime;
+    return 1;
+}
+
+int OS_ThreadDeadlines(uint32_t slot, uint32_t *period, uint32_t *jobs, uint32_t *misses) {
+    if (slot >= NUMTHREADS || !Threads[slot].used) return 0;
+    *period = Threads[slot].period;
+    *jobs = Threads[slot].jobs;
+    *misses = Threads[slot].misses;
+    return 1;
+}
+
+void OS_Suspend(void) { Yield(); }
+
+void OS_Sleep(unsigned long sleepTime) {
+    if (Current < 0) return;
+    Threads[Current].sleepCt = sleepTime;
+    SimProgress++;
+    Yield();
+}
+
+void OS_SetPeriod(unsigned long period, unsigned long deadline) {
+    struct SimThread *t = &Threads[Current];
+    if (t->period == 0) t->release = AbsMs;
+    t->period = period;
+    t->deadline = deadline;
+}
+
+void OS_WaitNextPeriod(void) {
+    struct SimThread *t = &Threads[Current];
+    if ((int32_t)(AbsMs - (t->release + t->deadline)) > 0) {
+        t->misses++;
+        SimMisses++;
+    }
+    t->jobs++;
+    SimJobs++;
+    t->release += t->period;
+    if ((int32_t)(t->release - AbsMs) < 0) t->release = AbsMs;
+    OS_Sleep(t->release - AbsMs);
+}
+
+void OS_Kill(void) {
+    Threads[Current].dead = 1;
+    NumLive--;
+    SimProgress++;
+    Yield();  // never comes back
+}
+
+// Semaphores ---------------------------------------------------------------------------------
+
+static int SemaFree(struct SimThread *t) { return ((Sema4Type *)t->waitOn)->Value > 0; }
+
+void OS_InitSemaphore(Sema4Type *semaPt, long value) { semaPt->Value = value; }
+
+void OS_Wait(Sema4Type *semaPt) {
+    OS_SemaphoreOps++;
+    if (semaPt->Value <= 0) {
+        Threads[Current].waitOn = semaPt;
+        WaitFor(SemaFree);
+    }
+    semaPt->Value -= 1;
+    SimProgress++;
+}
+
+void OS_Signal(Sema4Type *semaPt) {
+    OS_SemaphoreOps++;
+    semaPt->Value += 1;
+    SimProgress++;
+}
+
+void OS_bWait(Sema4Type *semaPt) {
+    OS_SemaphoreOps++;
+    if (semaPt->Value <= 0) {
+        Threads[Current].waitOn = semaPt;
+        WaitFor(SemaFree);
+    }
+    semaPt->Value = 0;
+    SimProgress++;
+}
+
+void OS_bSignal(Sema4Type *semaPt) {
+    OS_SemaphoreOps++;
+    semaPt->Value = 1;
+    SimProgress++;
+}
+
+// Barriers -----------------------------------------------------------------------------------
+
+static int BarrierMoved(struct SimThread *t) {
+    return ((BarrierType *)t->waitOn)->Phase != t->waitPhase;
+}
+
+static void BarrierRelease(BarrierType *barPt) {
+    barPt->Arrived = 0;
+    barPt->Phase++;
+    SimProgress++;
+}
+
+void OS_BarrierInit(BarrierType *barPt, long count) {
+    barPt->Count = count;
+    barPt->Arrived = 0;
+    barPt->Phase = 0;
+    barPt->Gate.Value = 0;
+}
+
+int OS_BarrierWait(BarrierType *barPt) {
+    barPt->Arrived++;
+    if (barPt->Arrived >= barPt->Count) {
+        BarrierRelease(barPt);
+        return 1;
+    }
+    Threads[Current].waitOn = barPt;
+    Threads[Current].waitPhase = barPt->Phase;
+    WaitFor(BarrierMoved);
+    return 0;
+}
+
+void OS_BarrierJoin(BarrierType *barPt) { barPt->Count++; }
+
+void OS_BarrierLeave(BarrierType *barPt) {
+    if (barPt->Count > 0) barPt->Count--;
+    if (barPt->Arrived > 0 && barPt->Arrived >= barPt->Count) {
+        BarrierRelease(barPt);
+    }
+}
+
+// Event flags --------------------------------------------------------------------------------
+
+static int FlagsReady(struct SimThread *t) {
+    unsigned long value = ((FlagsType *)t->waitOn)->Value;
+    if (t->waitMode & OS_FLAGS_ALL) {
+        return (value & t->waitBits) == t->waitBits;
+    }
+    return (value & t->waitBits) != 0;
+}
+
+void OS_FlagsInit(FlagsType *flagsPt, unsigned long value) {
+    flagsPt->Value = value;
+    flagsPt->Gate.Value = 0;
+}
+
+void OS_FlagsSet(FlagsType *flagsPt, unsigned long bits) {
+    flagsPt->Value |= bits;
+    SimProgress++;
+}
+
+void OS_FlagsClear(FlagsType *flagsPt, unsigned long bits) { flagsPt->Value &= ~bits; }
+
+unsigned long OS_FlagsWait(FlagsType *flagsPt, unsigned long bits, int mode) {
+    struct SimThread *t = &Threads[Current];
+    unsigned long got;
+    t->waitOn = flagsPt;
+    t->waitBits = bits;
+    t->waitMode = mode;
+    if (!FlagsReady(t)) {
+        WaitFor(FlagsReady);
+    }
+    got = flagsPt->Value & bits;
+    if (mode & OS_FLAGS_CLEAR) {
+        flagsPt->Value &= ~got;
+    }
+    return got;
+}
+
+// Software timers ----------------------------------------------------------------------------
+
+static int TimerWork(struct SimThread *t) { return TimersPending; }
+
+static void TimerDaemon(void) {
+    OSTimerType *pt;
+    while (1) {
+        WaitFor(TimerWork);
+        TimersPending = 0;
+        for (pt = Timers; pt; pt = pt->Next) {
+            if (pt->Pending) {
+                pt->Pending = 0;
+                pt->Task();
+            }
+        }
+    }
+}
+
+void OS_TimerCreate(OSTimerType *timerPt, void (*task)(void), unsigned long period) {
+    if (Timers == 0) {
+        OS_AddThread(&TimerDaemon, 128, 0);
+    }
+    timerPt->Task = task;
+    timerPt->Period = period;
+    timerPt->Remaining = 0;
+    timerPt->Active = 0;
+    timerPt->Pending = 0;
+    timerPt->Next = Timers;
+    Timers = timerPt;
+}
+
+void OS_TimerStart(OSTimerType *timerPt, unsigned long delay) {
+    if (!timerPt->Active) {
+        timerPt->Remaining = delay ? delay : 1;
+        timerPt->Active = 1;
+    }
+}
+
+void OS_TimerRestart(OSTimerType *timerPt, unsigned long delay) {
+    timerPt->Remaining = delay ? delay : 1;
+    timerPt->Pending = 0;
+    timerPt->Active = 1;
+}
+
+void OS_TimerCancel(OSTimerType *timerPt) {
+    timerPt->Active = 0;
+    timerPt->Pending = 0;
+}
+
+// Deferred work ------------------------------------------------------------------------------
+
+static int DeferWork(struct SimThread *t) { return DeferPutI != DeferGetI; }
+
+int OS_Defer(void (*task)(uint32_t arg), uint32_t arg) {
+    if (DeferPutI - DeferGetI == OS_DEFERSIZE) {
+        OS_DeferDropped++;
+        return 0;
+    }
+    DeferRing[DeferPutI & (OS_DEFERSIZE - 1)].task = task;
+    DeferRing[DeferPutI & (OS_DEFERSIZE - 1)].arg = arg;
+    DeferPutI++;
+    SimProgress++;
+    return 1;
+}
+
+static void DeferWorker(void) {
+    uint32_t i;
+    while (1) {
+        WaitFor(DeferWork);
+        i = DeferGetI++ & (OS_DEFERSIZE - 1);
+        DeferRing[i].task(DeferRing[i].arg);
+    }
+}
+
+// Time ---------------------------------------------------------------------------------------
+
+unsigned long OS_Time(void) {
+    SimCharge(SIM_CALL_CYCLES);
+    return (unsigned long)(uint32_t)SimCycles;
+}
+
+unsigned long OS_TimeDifference(unsigned long start, unsigned long stop) {
+    return (uint32_t)(stop - start);
+}
+
+void OS_ClearMsTime(void) { MsBase = SimCycles; }
+
+unsigned long OS_MsTime(void) {
+    SimCharge(SIM_CALL_CYCLES);
+    return (unsigned long)((SimCycles - MsBase) / TIME_1MS);
+}
+
+void OS_SetTimeSlice(unsigned long theTimeSlice) { TimeSlice = theTimeSlice; }
+unsigned long OS_TimeSlice(void) { return TimeSlice; }
+
+// the kernel trace is not simulated
+void OS_TraceEvent(uint8_t type, uint32_t arg) {}
+void OS_TraceStop(void) {}
+void OS_TraceStart(void) {}
+int OS_TraceRead(struct TraceRecord *buf, int max) { return 0; }
+
+// Periodic statistics, the same bookkeeping as os.c --------------------------------------------
+
+static PeriodicStatsType Stats[OS_MAXPERIODIC];
+static int NumStats;
+static struct PeriodicViolation Violations[OS_VIOLATIONSIZE];
+static unsigned long ViolationPutI;
+
+int OS_AddPeriodicSource(void (*task)(void), unsigned long period) {
+    if (NumStats == OS_MAXPERIODIC) return -1;
+    memset(&Stats[NumStats], 0, sizeof(Stats[NumStats]));
+    Stats[NumStats].Task = task;
+    Stats[NumStats].Period = period;
+    return NumStats++;
+}
+
+static void PeriodicViolation(int slot, uint8_t kind, unsigned long start, unsigned long finish) {
+    PeriodicStatsType *p = &Stats[slot];
+    struct PeriodicViolation *v = &Violations[ViolationPutI & (OS_VIOLATIONSIZE - 1)];
+    p->Overruns++;
+    p->Overrun = 1;
+    if (kind & PERIODIC_LONGRUN) p->LongRuns++;
+    if (kind & PERIODIC_LOST) p->Lost++;
+    if (kind & PERIODIC_NESTED) p->Nested++;
+    v->Seq = ViolationPutI++;
+    v->Start = start;
+    v->Finish = finish;
+    v->Slot = slot;
+    v->Kind = kind;
+}
+
+void OS_PeriodicRun(int slot) {
+    PeriodicStatsType *p = &Stats[slot];
+    unsigned long release = OS_Time(), diff, jitter, exec;
+    uint8_t kind = 0;
+    if (p->Running) {
+        PeriodicViolation(slot, PERIODIC_NESTED, release, release);
+        return;
+    }
+    if (p->Releases) {
+        diff = OS_TimeDifference(p->LastRelease, release);
+        jitter = (((diff > p->Period) ? diff - p->Period : p->Period - diff) + 4) / 8;
+        if (jitter > p->MaxJitter) p->MaxJitter = jitter;
+        p->Jitter[jitter < OS_JITTERSIZE ? jitter : OS_JITTERSIZE - 1]++;
+        if (diff >= 2 * p->Period) kind |= PERIODIC_LOST;
+    }
+    p->LastRelease = release;
+    p->Releases++;
+    p->Running = 1;
+    p->Task();
+    p->Running = 0;
+    p->LastFinish = OS_Time();
+    exec = OS_TimeDifference(release, p->LastFinish);
+    if (exec > p->MaxExec) p->MaxExec = exec;
+    if (exec >= p->Period) kind |= PERIODIC_LONGRUN;
+    if (kind) PeriodicViolation(slot, kind, release, p->LastFinish);
+}
+
+int OS_PeriodicViolations(unsigned long *seq, struct PeriodicViolation *buf, int max) {
+    int n = 0;
+    if (ViolationPutI - *seq > OS_VIOLATIONSIZE) *seq = ViolationPutI - OS_VIOLATIONSIZE;
+    while (n < max && *seq != ViolationPutI) {
+        buf[n++] = Violations[*seq & (OS_VIOLATIONSIZE - 1)];
+        (*seq)++;
+    }
+    return n;
+}
+
+const PeriodicStatsType *OS_PeriodicStats(uint32_t slot) {
+    return (slot < (uint32_t)NumStats) ? &Stats[slot] : 0;
+}
+
+void OS_PeriodicReset(void) {
+    int i;
+    for (i = 0; i < NumStats; i++) {
+        void (*task)(void) = Stats[i].Task;
+        unsigned long period = Stats[i].Period;
+        memset(&Stats[i], 0, sizeof(Stats[i]));
+        Stats[i].Task = task;
+        Stats[i].Period = period;
+    }
+}
+
+// Interrupts ---------------------------------------------------------------------------------
+
+void SimAddPeriodic(void (*task)(void), uint32_t period) {
+    if (NumPeriodic == SIMPERIODIC) return;
+    Periodic[NumPeriodic].task = task;
+    Periodic[NumPeriodic].slot = -1;
+    Periodic[NumPeriodic].period = period;
+    Periodic[NumPeriodic].next = SimCycles + period;
+    NumPeriodic++;
+}
+
+// like os.c, kept in rate monotonic order, so tasks due together run shortest period first
+int OS_AddPeriodicThread(void (*task)(void), unsigned long period, unsigned long priority) {
+    int slot = OS_AddPeriodicSource(task, period), i;
+    if (slot < 0 || NumPeriodic == SIMPERIODIC) return 0;
+    for (i = NumPeriodic; i > 0 && Periodic[i - 1].period > period; i--) {
+        Periodic[i] = Periodic[i - 1];
+    }
+    Periodic[i].task = task;
+    Periodic[i].slot = slot;
+    Periodic[i].period = period;
+    Periodic[i].next = SimCycles + period;
+    NumPeriodic++;
+    return 1;
+}
+
+// 1 ms tick, returns 1 if a thread woke up or a timer expired
+static int Tick(void) {
+    OSTimerType *pt;
+    int i, woke = 0;
+    AbsMs++;
+    for (i = 0; i < NUMTHREADS; i++) {
+        if (Threads[i].used && !Threads[i].dead && Threads[i].sleepCt) {
+            if (--Threads[i].sleepCt == 0) woke = 1;
+        }
+    }
+    for (pt = Timers; pt; pt = pt->Next) {
+        if (pt->Active && --pt->Remaining == 0) {
+            pt->Pending = 1;
+            TimersPending = 1;
+            woke = 1;
+            if (pt->Period) {
+                pt->Remaining = pt->Period;
+            } else {
+                pt->Active = 0;
+            }
+        }
+    }
+    InIsr = 1;
+    woke |= SimScript_Tick(AbsMs);
+    InIsr = 0;
+    return woke;
+}
+
+// run every interrupt that is due, returns 1 if anything happened
+static int Deliver(void) {
+    unsigned long progress;
+    int i, any = 0;
+    while (NextTick <= SimCycles) {
+        any |= Tick();
+        NextTick += TIME_1MS;
+    }
+    for (i = 0; i < NumPeriodic; i++) {
+        while (Periodic[i].next <= SimCycles) {
+            InIsr = 1;
+            if (Periodic[i].slot >= 0) {  // counts only if it signals, like the button sampler
+                progress = SimProgress;
+                OS_PeriodicRun(Periodic[i].slot);
+                any |= (SimProgress != progress);
+            } else {
+                Periodic[i].task();
+                any = 1;
+            }
+            InIsr = 0;
+            Periodic[i].next += Periodic[i].period;
+        }
+    }
+    if (any) SimProgress++;
+    return any;
+}
+
+// cycle the next tick or periodic task is due at
+static uint64_t NextInterrupt(void) {
+    uint64_t next = NextTick;
+    int i;
+    for (i = 0; i < NumPeriodic; i++) {
+        if (Periodic[i].next < next) next = Periodic[i].next;
+    }
+    return next;
+}
+
+// nothing can run, jump to the next interrupt that changes something
+static void Idle(void) {
+    uint64_t next;
+    do {
+        next = NextInterrupt();
+        if (next > SimCycles) SimCycles = next;
+    } while (!Deliver() && !SimDone());
+}
+
+static int Runnable(struct SimThread *t) {
+    return t->used && !t->dead && t->sleepCt == 0 && (t->ready == 0 || t->ready(t));
+}
+
+// 1 if the policy runs a before b
+static int Before(struct SimThread *a, struct SimThread *b) {
+    if (SimPolicy == SIM_PRIORITY) return a->priority < b->priority;
+    if ((a->priority == 0) != (b->priority == 0)) {
+        return a->priority == 0;  // SIM_EDF, bottom halves first like os.c
+    }
+    if (a->period == 0) return 0;  // threads without deadlines go last
+    if (b->period == 0) return 1;
+    return (int32_t)((a->release + a->deadline) - (b->release + b->deadline)) < 0;
+}
+
+// the thread to run after last, -1 if none can run
+// ties go to the first one in round robin order from last
+static int Pick(int last) {
+    int i, t, best = -1;
+    for (i = 1; i <= NUMTHREADS; i++) {
+        t = (last + i) % NUMTHREADS;
+        if (!Runnable(&Threads[t])) continue;
+        if (best < 0 || Before(&Threads[t], &Threads[best])) best = t;
+        if (SimPolicy == SIM_ROUNDROBIN) break;
+    }
+    return best;
+}
+
+// ******** OS_Launch ************
+// run the simulation until SimDone, then report and exit
+void OS_Launch(unsigned long theTimeSlice) {
+    unsigned long progress, quiet = 0;
+    int next = 0, pick;
+    TimeSlice = theTimeSlice;
+    while (!SimDone()) {
+        Deliver();
+        pick = Pick(next);
+        if (pick < 0 || quiet > NumLive) {
+            Idle();  // every thread is parked, sleeping or just yielding
+            quiet = 0;
+            continue;
+        }
+        progress = SimProgress;
+        next = pick;
+        Current = next;
+        if (Threads[next].execCount++ == 0) {
+            Threads[next].waitTime = (uint32_t)((SimCycles - Threads[next].arriveTime) / TIME_1MS);
+        }
+        SliceStart = SimCycles;
+        swapcontext(&SchedCtx, &Threads[next].ctx);
+        Current = -1;
+        SimSwitches++;
+        SimCycles += SIM_SWITCH_CYCLES;
+        if (Threads[next].dead && Threads[next].used) {
+            Threads[next].used = 0;  // its stack is reused by the next OS_AddThread
+        }
+        quiet = (SimProgress == progress) ? quiet + 1 : 0;
+    }
+    SimReport();
+    exit(0);
+}
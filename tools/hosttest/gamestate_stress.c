@@ -0,0 +1,135 @@
+// gamestate_stress.c
+// Runs on Linux
+// Stress test of the GameState.c seqlock with host threads.
+// Writer threads change every field of Game from one counter between
+// GameState_BeginWrite and GameState_EndWrite, and reader threads check
+// that each GameState_Read copy has all of its fields from the same
+// write.  StartCritical and EndCritical are a mutex here, so writers
+// exclude each other the way disabled interrupts do on the board, while
+// readers take no lock, and the host scheduler preempts them anywhere.
+// -u makes the readers copy Game without the seqlock, to show the check
+// catches torn copies.
+// GameState.c has no memory barriers: the board has one core, and on an
+// x86 host the volatile accesses keep their order too.  On a weakly
+// ordered multi-core host the test can fail without a bug in the game.
+//
+// usage: gamestate_stress [-s seconds] [-r readers] [-w writers] [-u]
+// Prints reads, writes, retries and torn copies; exits 1 if any copy was torn.
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "GameState.h"
+
+#define MAXTHREADS 16
+
+static pthread_mutex_t Interrupts = PTHREAD_MUTEX_INITIALIZER;
+static volatile int Stop;
+static int Unlocked;  // -u
+static unsigned long Reads[MAXTHREADS], Torn[MAXTHREADS], Writes[MAXTHREADS];
+
+long StartCritical(void) {
+    pthread_mutex_lock(&Interrupts);
+    return 0;
+}
+
+void EndCritical(long sr) { pthread_mutex_unlock(&Interrupts); }
+
+// every field follows from the counter, so a mix of two writes shows
+static void Fill(uint32_t n) {
+    Game.Score = n;
+    Game.Life = n * 7 + 1;
+    Game.CrosshairSize = -(int32_t)n;
+    Game.Speed = (int32_t)(n ^ 0x5A5A5A5A);
+    Game.Frozen = (int32_t)(n * 3);
+}
+
+static int Consistent(const struct GameState *s) {
+    uint32_t n = s->Score;
+    return s->Life == n * 7 + 1 && s->CrosshairSize == -(int32_t)n &&
+           s->Speed == (int32_t)(n ^ 0x5A5A5A5A) && s->Frozen == (int32_t)(n * 3);
+}
+
+static void *Writer(void *arg) {
+    long i = (long)arg, sr;
+    while (!Stop) {
+        sr = GameState_BeginWrite();
+        Fill(Game.Score + 1);
+        GameState_EndWrite(sr);
+        Writes[i]++;
+    }
+    return 0;
+}
+
+static void *Reader(void *arg) {
+    long i = (long)arg;
+    struct GameState copy;
+    while (!Stop) {
+        if (Unlocked) {
+            copy.Score = Game.Score;
+            copy.Life = Game.Life;
+            copy.CrosshairSize = Game.CrosshairSize;
+            copy.Speed = Game.Speed;
+            copy.Frozen = Game.Frozen;
+        } else {
+            GameState_Read(&copy);
+        }
+        if (!Consistent(&copy)) Torn[i]++;
+        Reads[i]++;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    pthread_t threads[2 * MAXTHREADS];
+    unsigned long reads = 0, writes = 0, torn = 0;
+    int seconds = 2, readers = 3, writers = 2, i;
+    struct timespec duration;
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            seconds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            readers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            writers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-u") == 0) {
+            Unlocked = 1;
+        } else {
+            fprintf(stderr, "usage: gamestate_stress [-s seconds] [-r readers] [-w writers] [-u]\n");
+            return 2;
+        }
+    }
+    if (readers < 1 || readers > MAXTHREADS || writers < 1 || writers > MAXTHREADS) {
+        fprintf(stderr, "gamestate_stress: 1 to %d readers and writers\n", MAXTHREADS);
+        return 2;
+    }
+    GameState_Init(0, 0);
+    Fill(0);
+    for (i = 0; i < writers; i++) {
+        pthread_create(&threads[i], 0, Writer, (void *)(long)i);
+    }
+    for (i = 0; i < readers; i++) {
+        pthread_create(&threads[MAXTHREADS + i], 0, Reader, (void *)(long)i);
+    }
+    duration.tv_sec = seconds;
+    duration.tv_nsec = 0;
+    nanosleep(&duration, 0);
+    Stop = 1;
+    for (i = 0; i < writers; i++) {
+        pthread_join(threads[i], 0);
+        writes += Writes[i];
+    }
+    for (i = 0; i < readers; i++) {
+        pthread_join(threads[MAXTHREADS + i], 0);
+        reads += Reads[i];
+        torn += Torn[i];
+    }
+    printf("reads %lu\n", reads);
+    printf("writes %lu\n", writes);
+    printf("retries %lu\n", GameState_Retries);
+    printf("torn %lu\n", torn);
+    return torn != 0;
+}
@@ -0,0 +1,273 @@
+// grid_bench.c
+// Runs on Linux
+// Cube moves per second on the Grid.c bitboard against the Sema4Type
+// array Main.c used before, with the same random walk on both.
+// Each move picks a cube, finds its free neighbours, picks one of them
+// and moves there, the work StepCubes does per cube.  The old array
+// path is get_movable_directions, then OS_bWait on the target and
+// OS_bSignal on the source inside StartCritical, as it was in Main.c;
+// its OS_bWait and OS_bSignal are the fast path of the default os.c
+// build (no blockSema), kept out of line like the real ones.
+// Both walks see the same random numbers, so they have to end with the
+// same cubes in the same cells; the bench fails if they do not.
+// The random picks cost as much as the occupancy work, so the first
+// REPLAYMOVES moves are recorded and replayed on both as well, without
+// the picks, the best of REPLAYPASSES, to time the occupancy work alone.
+//
+// usage: grid_bench [-m moves] [-c cubes]
+// Prints moves per host second of each walk and the speedup, then ns
+// per replayed move of each and that speedup.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "os.h"
+#include "Grid.h"
+
+#define MAXCUBES (GRID_COLUMNS * GRID_ROWS)
+#define REPLAYMOVES 1000000
+#define REPLAYPASSES 10
+
+// old enum Direction order, the same as the GRID_ bits
+enum Direction { UP, DOWN, LEFT, RIGHT };
+
+static volatile long Critical;  // interrupts are not simulated, this keeps the calls
+unsigned long OS_SemaphoreOps;
+
+long StartCritical(void) { return Critical++; }
+void EndCritical(long sr) { Critical = sr; }
+
+__attribute__((noinline)) void OS_DisableInterrupts(void) { Critical = 1; }
+__attribute__((noinline)) void OS_EnableInterrupts(void) { Critical = 0; }
+
+void OS_InitSemaphore(Sema4Type *semaPt, long value) { semaPt->Value = value; }
+
+__attribute__((noinline)) void OS_bWait(Sema4Type *semaPt) {
+    OS_DisableInterrupts();
+    OS_SemaphoreOps++;
+    if (semaPt->Value == 0) {
+        fprintf(stderr, "grid_bench: bWait on a taken cell\n");  // would spin forever
+        exit(1);
+    }
+    semaPt->Value = 0;
+    OS_EnableInterrupts();
+}
+
+__attribute__((noinline)) void OS_bSignal(Sema4Type *semaPt) {
+    OS_DisableInterrupts();
+    OS_SemaphoreOps++;
+    semaPt->Value = 1;
+    OS_EnableInterrupts();
+}
+
+struct Cube {
+    int x, y;
+};
+
+static struct Cube OldCubes[MAXCUBES], NewCubes[MAXCUBES];
+static Sema4Type blocks[GRID_ROWS][GRID_COLUMNS];  // 1 when free
+static uint8_t Moves[REPLAYMOVES][2];               // cube and direction of each move
+static long NumMoves;
+
+static uint32_t Seed;
+static uint32_t Random(void) {
+    Seed = Seed * 1664525 + 1013904223;
+    return Seed >> 8;
+}
+
+// get_movable_directions from Main.c before the grid
+static int OldDirections(struct Cube *cube, int8_t *dirs) {
+    int total = 0;
+    dirs[LEFT] = cube->x > 0 && blocks[cube->y][cube->x - 1].Value;
+    dirs[RIGHT] = cube->x < GRID_COLUMNS - 1 && blocks[cube->y][cube->x + 1].Value;
+    dirs[UP] = cube->y > 0 && blocks[cube->y - 1][cube->x].Value;
+    dirs[DOWN] = cube->y < GRID_ROWS - 1 && blocks[cube->y + 1][cube->x].Value;
+    total = dirs[LEFT] + dirs[RIGHT] + dirs[UP] + dirs[DOWN];
+    return total;
+}
+
+static void OldStart(int cubes) {
+    int i, x, y;
+    for (y = 0; y < GRID_ROWS; y++) {
+        for (x = 0; x < GRID_COLUMNS; x++) OS_InitSemaphore(&blocks[y][x], 1);
+    }
+    for (i = 0; i < cubes; i++) {  // the first cells in row order
+        OldCubes[i].x = i % GRID_COLUMNS;
+        OldCubes[i].y = i / GRID_COLUMNS;
+        OS_bWait(&blocks[OldCubes[i].y][OldCubes[i].x]);
+    }
+}
+
+// one move as MoveCube did it, -1 if the cube is boxed in
+static int OldMove(struct Cube *cube, int dir) {
+    int8_t dirs[4];
+    int x, y;
+    long status;
+    status = StartCritical();
+    if (OldDirections(cube, dirs) == 0 || !dirs[dir]) {
+        EndCritical(status);
+        return -1;
+    }
+    x = cube->x + (dir == RIGHT) - (dir == LEFT);
+    y = cube->y + (dir == DOWN) - (dir == UP);
+    OS_bWait(&blocks[y][x]);
+    OS_bSignal(&blocks[cube->y][cube->x]);
+    EndCritical(status);
+    cube->x = x;
+    cube->y = y;
+    return dir;
+}
+
+static void OldWalk(int cubes, long moves) {
+    struct Cube *cube;
+    int8_t dirs[4];
+    int total, pick, i, x, y;
+    long n, status;
+    OldStart(cubes);
+    for (n = 0; n < moves; n++) {
+        cube = &OldCubes[Random() % cubes];
+        status = StartCritical();
+        total = OldDirections(cube, dirs);
+        if (total == 0) {
+            EndCritical(status);
+            continue;
+        }
+        pick = Random() % total;
+        for (i = 0; i < 4; i++) {
+            if (dirs[i] && pick-- == 0) break;
+        }
+        x = cube->x + (i == RIGHT) - (i == LEFT);
+        y = cube->y + (i == DOWN) - (i == UP);
+        OS_bWait(&blocks[y][x]);
+        OS_bSignal(&blocks[cube->y][cube->x]);
+        EndCritical(status);
+        cube->x = x;
+        cube->y = y;
+    }
+}
+
+static void NewStart(int cubes) {
+    int i;
+    Grid_Clear();
+    for (i = 0; i < cubes; i++) {
+        NewCubes[i].x = i % GRID_COLUMNS;
+        NewCubes[i].y = i / GRID_COLUMNS;
+        Grid_Take(NewCubes[i].x, NewCubes[i].y);
+    }
+}
+
+// one move as MoveCube does it, -1 if the cube is boxed in
+static int NewMove(struct Cube *cube, int dir) {
+    uint32_t dirs = Grid_FreeDirections(cube->x, cube->y);
+    if (!(dirs & (1u << dir)) || !Grid_Move(cube->x, cube->y, 1u << dir)) return -1;
+    cube->x += (dir == RIGHT) - (dir == LEFT);
+    cube->y += (dir == DOWN) - (dir == UP);
+    return dir;
+}
+
+static void NewWalk(int cubes, long moves) {
+    struct Cube *cube;
+    uint32_t dirs, bits;
+    int total, pick, i;
+    long n;
+    NewStart(cubes);
+    NumMoves = 0;
+    for (n = 0; n < moves; n++) {
+        cube = &NewCubes[Random() % cubes];
+        dirs = Grid_FreeDirections(cube->x, cube->y);
+        if (dirs == 0) continue;
+        total = __builtin_popcount(dirs);
+        pick = Random() % total;
+        for (i = 0, bits = dirs; i < 4; i++) {  // the same pick order as the old walk
+            if ((bits & (1u << i)) && pick-- == 0) break;
+        }
+        if (!Grid_Move(cube->x, cube->y, 1u << i)) {
+            fprintf(stderr, "grid_bench: Grid_Move into a free cell failed\n");
+            exit(1);
+        }
+        cube->x += (i == RIGHT) - (i == LEFT);
+        cube->y += (i == DOWN) - (i == UP);
+        if (NumMoves < REPLAYMOVES) {
+            Moves[NumMoves][0] = cube - NewCubes;
+            Moves[NumMoves][1] = i;
+            NumMoves++;
+        }
+    }
+}
+
+// replays the recorded moves on one of them, returns the fastest pass in s
+static double Replay(int cubes, void (*start)(int cubes), struct Cube *all,
+                     int (*move)(struct Cube *cube, int dir)) {
+    struct timespec t0, t1;
+    double s, best = 1e30;
+    long n;
+    int pass;
+    for (pass = 0; pass < REPLAYPASSES; pass++) {
+        start(cubes);
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (n = 0; n < NumMoves; n++) {
+            if (move(&all[Moves[n][0]], Moves[n][1]) < 0) {
+                fprintf(stderr, "grid_bench: replayed move %ld is blocked\n", n);
+                exit(1);
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        s = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+        if (s < best) best = s;
+    }
+    return best;
+}
+
+static double Seconds(struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+    struct timespec start;
+    long moves = 10000000;
+    int cubes = 10, i;
+    double oldS, newS, oldReplay, newReplay;
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            moves = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            cubes = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: grid_bench [-m moves] [-c cubes]\n");
+            return 2;
+        }
+    }
+    if (cubes < 1 || cubes > MAXCUBES) {
+        fprintf(stderr, "grid_bench: 1 to %d cubes\n", MAXCUBES);
+        return 2;
+    }
+    Seed = 1;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    OldWalk(cubes, moves);
+    oldS = Seconds(&start);
+    Seed = 1;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    NewWalk(cubes, moves);
+    newS = Seconds(&start);
+    printf("cubes %d\n", cubes);
+    printf("semaphore_moves_per_s %.0f\n", moves / oldS);
+    printf("grid_moves_per_s %.0f\n", moves / newS);
+    printf("speedup %.2f\n", oldS / newS);
+    for (i = 0; i < cubes; i++) {
+        if (OldCubes[i].x != NewCubes[i].x || OldCubes[i].y != NewCubes[i].y) {
+            printf("FAIL cube %d is at %d,%d on the grid and %d,%d in the array\n", i,
+                   NewCubes[i].x, NewCubes[i].y, OldCubes[i].x, OldCubes[i].y);
+            return 1;
+        }
+    }
+    oldReplay = Replay(cubes, OldStart, OldCubes, OldMove);
+    newReplay = Replay(cubes, NewStart, NewCubes, NewMove);
+    printf("semaphore_replay_ns_per_move %.2f\n", oldReplay * 1e9 / NumMoves);
+    printf("grid_replay_ns_per_move %.2f\n", newReplay * 1e9 / NumMoves);
+    printf("replay_speedup %.2f\n", oldReplay / newReplay);
+    return 0;
+}
@@ -0,0 +1,312 @@
+// input_test.c
+// Runs on Linux
+// Host test of the joystick pipeline in Input.c and Calibration.c.
+// Synthetic ADC traces (or a recorded one) go through Input_Delta and,
+// for comparison, the per-sample divide by origin[] that UpdatePosition
+// in Main.c used before, and the test reports for each:
+//   rest   noise around the center: samples that moved the cursor and
+//          how far it drifted, the filter and dead zone should hold it
+//   hold   the stick held still at every deflection in turn: samples
+//          whose step differs from the one before, the cursor jitter
+//   step   rest then full deflection: samples until the first step and
+//          until full speed, the delay the filter adds
+//   sweep  slow sweep from rest to full: distinct step sizes on the way,
+//          the resolution of the response curve
+//   cost   host ns per sample over a slow sweep, and TSC cycles on x86,
+//          the best of COSTPASSES passes since a shared host is noisy;
+//          the board is slower, compare the two pipelines, not the numbers
+// The old pipeline sees single conversions with the given noise; the new
+// one sees the 16 conversion hardware average (ADC0_SAC_R in joystick.c),
+// which has a quarter of it.
+// The checks at the end fail the test if the new pipeline moves at rest
+// with the default noise, jitters more than the old one while held, takes
+// more than MAXLAG samples to start moving after a step, or is not
+// symmetric.
+//
+// usage: input_test [-n noise] [-f trace]
+//   -n  standard deviation of the ADC noise in counts, default 8
+//   -f  recorded trace, one "x y" pair of raw ADC values per line;
+//       the first sample is taken as the rest position
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef __x86_64__
+#include <x86intrin.h>
+#endif
+#include "Input.h"
+#include "Calibration.h"
+
+#define BASESPEED 6  // CURSOR_BASE_SPEED in Main.c
+#define CENTER 2048
+#define HWAVERAGE 4  // 16 conversions averaged, a quarter of the noise
+#define SAMPLES 1000000
+#define COSTPASSES 20  // SAMPLES split into passes, the fastest one counts
+#define MAXLAG 3     // samples a full step may take to move the cursor
+#define MAXTRACE 100000
+
+// no critical sections or EEPROM on the host, Cal_Init starts over
+long StartCritical(void) { return 0; }
+void EndCritical(long sr) {}
+void EEPROMRead(uint32_t *data, uint32_t address, uint32_t count) { memset(data, 0, count); }
+uint32_t EEPROMProgram(uint32_t *data, uint32_t address, uint32_t count) { return 0; }
+
+typedef void DeltaFunc(uint16_t rawx, uint16_t rawy, int16_t *dx, int16_t *dy);
+
+static uint16_t TraceX[MAXTRACE], TraceY[MAXTRACE];
+static int TraceSize;
+
+// the rest reading and speed level UpdatePosition used, not constants
+// so the compiler keeps the divides
+uint16_t Origin[2];
+int Speed;
+
+// UpdatePosition before the pipeline, one divide per axis
+static void OldDelta(uint16_t rawx, uint16_t rawy, int16_t *dx, int16_t *dy) {
+    if (Speed > 0) {
+        *dx = (rawx - Origin[0]) * (BASESPEED << Speed) / Origin[0];
+        *dy = (Origin[1] - rawy) * (BASESPEED << Speed) / Origin[1];
+    } else {
+        *dx = (rawx - Origin[0]) * (BASESPEED >> -Speed) / Origin[0];
+        *dy = (Origin[1] - rawy) * (BASESPEED >> -Speed) / Origin[1];
+    }
+}
+
+static void NewDelta(uint16_t rawx, uint16_t rawy, int16_t *dx, int16_t *dy) {
+    Input_Delta(rawx, rawy, Speed, dx, dy);
+}
+
+static void Reset(uint16_t restx, uint16_t resty) {
+    Origin[0] = restx;
+    Origin[1] = resty;
+    Speed = 0;
+    Cal_Init(restx, resty);
+    Input_Init(BASESPEED);
+}
+
+// roughly normal noise from the sum of four uniform draws
+static uint32_t Seed = 1;
+static int Noise(double sigma) {
+    int32_t sum = 0;
+    int i;
+    for (i = 0; i < 4; i++) {
+        Seed = Seed * 1664525 + 1013904223;
+        sum += (int32_t)(Seed >> 16) - 32768;
+    }
+    return (int)(sum * sigma / 37837.0);  // 4 uniforms of 65536 have sd 37837
+}
+
+static uint16_t Clamp(int v) { return v < 0 ? 0 : v > 4095 ? 4095 : v; }
+
+// noise each pipeline sees for a single conversion noise of sigma
+static double Sigma(DeltaFunc *delta, double sigma) {
+    return delta == NewDelta ? sigma / HWAVERAGE : sigma;
+}
+
+static int Rest(const char *name, DeltaFunc *delta, double sigma) {
+    int16_t dx, dy;
+    long x = 0, y = 0, path = 0;
+    int i, moved = 0;
+    Reset(CENTER, CENTER);
+    Seed = 1;
+    sigma = Sigma(delta, sigma);
+    for (i = 0; i < 10000; i++) {
+        delta(Clamp(CENTER + Noise(sigma)), Clamp(CENTER + Noise(sigma)), &dx, &dy);
+        if (dx || dy) moved++;
+        x += dx;
+        y += dy;
+        path += abs(dx) + abs(dy);
+    }
+    printf("%s_rest_moving_pct %.2f\n", name, moved / 100.0);
+    printf("%s_rest_path_px %ld\n", name, path);
+    printf("%s_rest_drift_px %ld\n", name, labs(x) + labs(y));
+    return moved;
+}
+
+// returns the percentage of held samples whose step changed
+static double Hold(const char *name, DeltaFunc *delta, double sigma) {
+    int16_t dx, dy, last;
+    long changes = 0, samples = 0;
+    int d, i;
+    Reset(CENTER, CENTER);
+    Seed = 1;
+    sigma = Sigma(delta, sigma);
+    for (d = 0; d < CENTER; d += 8) {
+        for (i = 0; i < 20; i++) delta(CENTER + d, CENTER, &dx, &dy);  // settle
+        last = dx;
+        for (i = 0; i < 100; i++) {
+            delta(Clamp(CENTER + d + Noise(sigma)), CENTER, &dx, &dy);
+            if (dx != last) changes++;
+            last = dx;
+            samples++;
+        }
+    }
+    printf("%s_hold_changes_pct %.2f\n", name, 100.0 * changes / samples);
+    return 100.0 * changes / samples;
+}
+
+// returns samples until the first step, and the full speed in *speed
+static int Step(const char *name, DeltaFunc *delta, uint16_t target, int *speed) {
+    int16_t dx, dy;
+    int i, first = -1, full = -1;
+    Reset(CENTER, CENTER);
+    for (i = 0; i < 100; i++) delta(CENTER, CENTER, &dx, &dy);
+    *speed = 0;
+    for (i = 0; i < 100; i++) {
+        delta(target, CENTER, &dx, &dy);
+        if (dx && first < 0) first = i + 1;
+        if (abs(dx) > abs(*speed)) {
+            *speed = dx;
+            full = i + 1;
+        }
+    }
+    printf("%s_step%u_first %d\n", name, target, first);
+    printf("%s_step%u_full %d\n", name, target, full);
+    printf("%s_step%u_speed %d\n", name, target, *speed);
+    return first;
+}
+
+static void Sweep(const char *name, DeltaFunc *delta) {
+    int16_t dx, dy, last = 0;
+    int v, levels = 0;
+    Reset(CENTER, CENTER);
+    for (v = CENTER; v <= 4095; v++) {
+        delta(v, CENTER, &dx, &dy);
+        delta(v, CENTER, &dx, &dy);  // let the filter settle
+        delta(v, CENTER, &dx, &dy);
+        delta(v, CENTER, &dx, &dy);
+        if (dx != last) levels++;
+        last = dx;
+    }
+    printf("%s_sweep_levels %d\n", name, levels);
+}
+
+// -amp to amp and back over one period
+static int Triangle(int i, int period, int amp) {
+    i %= period;
+    if (i < period / 2) return -amp + 4 * amp * i / period;
+    return 3 * amp - 4 * amp * i / period;
+}
+
+static void Cost(const char *name, DeltaFunc *delta) {
+    struct timespec start, stop;
+    int16_t dx, dy;
+    long sum = 0;
+    double ns, best = 1e30;
+    int i, pass;
+#ifdef __x86_64__
+    uint64_t tsc, bestTsc = ~0ull;
+#endif
+    Reset(CENTER, CENTER);
+    Seed = 1;
+    // the stick sweeping both axes, a quarter period apart, drawn first
+    // since the noise costs more than the pipeline
+    for (i = 0; i < 4096; i++) {
+        TraceX[i] = Clamp(CENTER + Triangle(i, 4096, 2000) + Noise(Sigma(delta, 8)));
+        TraceY[i] = Clamp(CENTER + Triangle(i + 1024, 4096, 2000) + Noise(Sigma(delta, 8)));
+    }
+    for (pass = 0; pass < COSTPASSES; pass++) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+#ifdef __x86_64__
+        tsc = __rdtsc();
+#endif
+        for (i = 0; i < SAMPLES / COSTPASSES; i++) {
+            delta(TraceX[i & 4095], TraceY[i & 4095], &dx, &dy);
+            sum += dx + dy;
+        }
+#ifdef __x86_64__
+        tsc = __rdtsc() - tsc;
+        if (tsc < bestTsc) bestTsc = tsc;
+#endif
+        clock_gettime(CLOCK_MONOTONIC, &stop);
+        ns = (stop.tv_sec - start.tv_sec) * 1e9 + (stop.tv_nsec - start.tv_nsec);
+        if (ns < best) best = ns;
+    }
+#ifdef __x86_64__
+    printf("%s_cost_tsc %.1f\n", name, (double)bestTsc * COSTPASSES / SAMPLES);
+#endif
+    printf("%s_cost_ns %.1f\n", name, best * COSTPASSES / SAMPLES);
+    if (sum == 42) printf("\n");  // keeps the loop
+}
+
+static void ReadTrace(const char *file) {
+    FILE *f = fopen(file, "r");
+    unsigned x, y;
+    if (f == 0) {
+        perror(file);
+        exit(2);
+    }
+    while (TraceSize < MAXTRACE && fscanf(f, "%u %u", &x, &y) == 2) {
+        TraceX[TraceSize] = Clamp(x);
+        TraceY[TraceSize] = Clamp(y);
+        TraceSize++;
+    }
+    fclose(f);
+}
+
+// the recorded trace through both pipelines, from its first sample
+static void Recorded(const char *name, DeltaFunc *delta) {
+    int16_t dx, dy;
+    long path = 0;
+    int i, moved = 0;
+    Reset(TraceX[0], TraceY[0]);
+    for (i = 0; i < TraceSize; i++) {
+        delta(TraceX[i], TraceY[i], &dx, &dy);
+        if (dx || dy) moved++;
+        path += abs(dx) + abs(dy);
+    }
+    printf("%s_trace_samples %d\n", name, TraceSize);
+    printf("%s_trace_moving_pct %.2f\n", name, TraceSize ? 100.0 * moved / TraceSize : 0);
+    printf("%s_trace_path_px %ld\n", name, path);
+}
+
+int main(int argc, char *argv[]) {
+    double sigma = 8, oldHold, newHold;
+    int moved, speedUp, speedDown, lagUp, lagDown, fail = 0, i;
+    const char *trace = 0;
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            sigma = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            trace = argv[++i];
+        } else {
+            fprintf(stderr, "usage: input_test [-n noise] [-f trace]\n");
+            return 2;
+        }
+    }
+    Rest("old", OldDelta, sigma);
+    oldHold = Hold("old", OldDelta, sigma);
+    Step("old", OldDelta, 4095, &speedUp);
+    Sweep("old", OldDelta);
+    Cost("old", OldDelta);
+    moved = Rest("new", NewDelta, sigma);
+    newHold = Hold("new", NewDelta, sigma);
+    lagUp = Step("new", NewDelta, 4095, &speedUp);
+    lagDown = Step("new", NewDelta, 0, &speedDown);
+    Sweep("new", NewDelta);
+    Cost("new", NewDelta);
+    if (trace) {
+        ReadTrace(trace);  // a recorded trace has the hardware average in it already
+        Recorded("old", OldDelta);
+        Recorded("new", NewDelta);
+    }
+    if (moved && sigma <= 8) {
+        printf("FAIL new pipeline moves at rest\n");
+        fail = 1;
+    }
+    if (newHold > oldHold) {
+        printf("FAIL new pipeline jitters more than the old one while held\n");
+        fail = 1;
+    }
+    if (lagUp < 1 || lagUp > MAXLAG || lagDown < 1 || lagDown > MAXLAG) {
+        printf("FAIL new pipeline lags a step by more than %d samples\n", MAXLAG);
+        fail = 1;
+    }
+    if (speedUp != -speedDown) {
+        printf("FAIL new pipeline full speed %d one way, %d the other\n", speedUp, speedDown);
+        fail = 1;
+    }
+    return fail;
+}
@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+# replay.py
+# Turn a telemetry capture recorded with REPLAY_MODE REPLAY_RECORD into
+# ReplayLog.c for REPLAY_MODE REPLAY_PLAY.  See Replay.h for the log format.
+#
+# usage: python3 replay.py capture.bin > ../ReplayLog.c
+# The first session in the capture is used; a second header starts a
+# new session and ends the log.  A capture with a missing record frame
+# (the chunk numbers after the header skip one) is rejected, since the
+# replayed game would go another way from there.
+
+import struct
+import sys
+
+import teldecode
+
+REPLAY_HEADER = 0
+REPLAY_RECORDS = 1
+REPLAY_BUTTON = 1
+REPLAY_STEP = 2
+
+
+def session(stream):
+    """Return (header tuple, list of record data words) of the first session.
+
+    Exits if a record frame of the session is missing.
+    """
+    header = None
+    records = []
+    expect = 0  # chunk number of the next record frame
+    for ftype, fid, _, payload in teldecode.frames(stream):
+        if ftype != teldecode.TEL_REPLAY:
+            continue
+        if fid == REPLAY_HEADER and len(payload) == 40:
+            if header is not None:
+                break
+            header = struct.unpack("<II6iII", payload)
+        elif fid == REPLAY_RECORDS and header is not None and len(payload) >= 4:
+            seq = struct.unpack("<I", payload[:4])[0]
+            if seq != expect:
+                sys.exit("replay chunk %d follows chunk %d, frames lost: %d; "
+                         "record again with less telemetry traffic"
+                         % (seq, expect - 1, (seq - expect) & 0xFFFFFFFF))
+            expect = seq + 1
+            for i in range(4, len(payload) - 5, 6):
+                records.append(struct.unpack("<HI", payload[i:i + 6])[1])
+    return header, records
+
+
+def main():
+    if len(sys.argv) > 1:
+        with open(sys.argv[1], "rb") as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+    header, records = session(data)
+    if header is None:
+        sys.exit("no replay header in the capture, was REPLAY_RECORD on?")
+    buttons = sum(1 for r in records if r >> 30 == REPLAY_BUTTON)
+    steps = sum(1 for r in records if r >> 30 == REPLAY_STEP)
+    out = sys.stdout
+    out.write("// ReplayLog.c\n")
+    out.write("// Runs on LM4F120/TM4C123\n")
+    out.write("// Session log played back when REPLAY_MODE is REPLAY_PLAY, see Replay.h.\n")
+    out.write("// Generated by tools/replay.py: %d joystick samples, %d button events,\n"
+              % (len(records) - buttons - steps, buttons))
+    out.write("// %d cube steps every %d ms against a sample every %d ms.\n\n"
+              % (steps, header[8], header[9]))
+    out.write("#include <stdint.h>\n#include \"Replay.h\"\n\n")
+    out.write("const struct ReplayHeader ReplayLogHeader = {0x%08X, 0x%08X, {%s}, %d, %d};\n"
+              % (header[0], header[1], ", ".join(str(v) for v in header[2:8]),
+                 header[8], header[9]))
+    out.write("const uint32_t ReplayLog[] = {\n")
+    for i in range(0, len(records), 6):
+        out.write("    " + ", ".join("0x%08X" % r for r in records[i:i + 6]) + ",\n")
+    if not records:
+        out.write("    0,\n")
+    out.write("};\n")
+    out.write("const uint32_t ReplayLogSize = %d;\n" % len(records))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+# teldecode.py
+# Decode a binary telemetry capture from UART0 into CSV.
+# See Telemetry.h for the frame format.
+#
+# usage: python3 teldecode.py capture.bin > capture.csv
+#        python3 teldecode.py < capture.bin
+# Capture with any raw serial logger at 115200 8N1, e.g.
+#        stty -F /dev/ttyACM0 115200 raw && cat /dev/ttyACM0 > capture.bin
+
+import struct
+import sys
+
+TEL_COUNTER = 1
+TEL_HISTOGRAM = 2
+TEL_EVENT = 3
+TEL_THREAD = 4
+TEL_TRACE = 5
+TEL_REPLAY = 6
+TEL_PERIODIC = 7
+TEL_VIOLATION = 8
+
+TYPE_NAMES = {
+    TEL_COUNTER: "counter",
+    TEL_HISTOGRAM: "histogram",
+    TEL_EVENT: "event",
+    TEL_THREAD: "thread",
+    TEL_TRACE: "trace",
+    TEL_REPLAY: "replay",
+    TEL_PERIODIC: "periodic",
+    TEL_VIOLATION: "violation",
+}
+
+# keep in sync with the TEL_ID_ defines in Telemetry.h
+ID_NAMES = {
+    1: "DataLost",
+    2: "MaxJitter",
+    3: "JitterHistogram",
+    4: "Score",
+    5: "Life",
+    6: "ConsumerCount",
+    7: "UpdateWork",
+    8: "TelDropped",
+    9: "MaxIsrTime",
+    10: "SemaOps",
+    11: "ConsumerHist",
+    12: "DrawHist",
+    13: "AutoGames",
+    14: "StepHist",
+    15: "WaveHist",
+    16: "ClearHist",
+    17: "DeferDropped",
+    18: "DeferHist",
+    19: "ProducerHist",
+}
+TEL_ID_PERIODICJITTER = 32  # plus the periodic slot
+
+# PERIODIC_ violation kind bits in os.h
+VIOLATION_KINDS = ((0x01, "longrun"), (0x02, "lost"), (0x04, "nested"))
+
+# struct ReplayHeader in Replay.h
+REPLAY_HEADER = ("seedA", "seedB", "xcenter", "xmin", "xmax", "ycenter", "ymin", "ymax",
+                 "stepms", "samplems")
+
+
+def crc16(data):
+    """CRC-16 (poly 0xA001 reflected, init 0), same as Crc16() in sw_crc.c"""
+    crc = 0
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def frames(stream):
+    """Yield (type, id, time_ms, payload) for every frame with a good CRC.
+    Bytes between delimiters that do not decode are skipped."""
+    for chunk in stream.split(b"\x00"):
+        if not chunk:
+            continue
+        raw = cobs_decode(chunk)
+        if raw is None or len(raw) < 8:
+            continue
+        body, crc = raw[:-2], struct.unpack("<H", raw[-2:])[0]
+        if crc16(body) != crc:
+            continue
+        ftype, fid, time_ms = struct.unpack("<BBI", body[:6])
+        yield ftype, fid, time_ms, body[6:]
+
+
+def rows(stream):
+    """Yield CSV rows (time_ms, type, id, name, field, value)."""
+    for ftype, fid, time_ms, payload in frames(stream):
+        tname = TYPE_NAMES.get(ftype, str(ftype))
+        if ftype == TEL_THREAD:
+            name = "thread%d" % fid
+        elif ftype == TEL_PERIODIC:
+            name = "periodic%d" % fid
+        elif ftype == TEL_HISTOGRAM and fid >= TEL_ID_PERIODICJITTER:
+            name = "Jitter%d" % (fid - TEL_ID_PERIODICJITTER)
+        else:
+            name = ID_NAMES.get(fid, "id%d" % fid)
+        if ftype in (TEL_COUNTER, TEL_EVENT) and len(payload) == 4:
+            yield time_ms, tname, fid, name, "", struct.unpack("<I", payload)[0]
+        elif ftype == TEL_HISTOGRAM and len(payload) >= 2:
+            first, count = payload[0], payload[1]
+            bins = struct.unpack("<%dI" % count, payload[2:2 + 4 * count])
+            for i, v in enumerate(bins):
+                yield time_ms, tname, fid, name, first + i, v
+        elif ftype == TEL_TRACE:
+            for i in range(0, len(payload) - 9, 10):
+                time, etype, thread, arg = struct.unpack("<IBBI", payload[i:i + 10])
+                yield time_ms, tname, etype, "thread%d" % thread, time, arg
+        elif ftype == TEL_REPLAY and fid == 0 and len(payload) == 40:
+            for field, v in zip(REPLAY_HEADER, struct.unpack("<II6iII", payload)):
+                yield time_ms, tname, fid, "header", field, v
+        elif ftype == TEL_REPLAY and fid == 1 and len(payload) >= 4:
+            seq = struct.unpack("<I", payload[:4])[0]
+            for i in range(4, len(payload) - 5, 6):
+                stamp, data = struct.unpack("<HI", payload[i:i + 6])
+                yield time_ms, tname, fid, "record%d" % seq, stamp, "%08x" % data
+        elif ftype == TEL_PERIODIC and len(payload) == 16:
+            fields = ("releases", "maxjitter", "maxexec", "overruns")
+            for field, v in zip(fields, struct.unpack("<4I", payload)):
+                yield time_ms, tname, fid, name, field, v
+        elif ftype == TEL_VIOLATION:
+            for i in range(0, len(payload) - 13, 14):
+                seq, start, finish, slot, kind = struct.unpack("<IIIBB", payload[i:i + 14])
+                kinds = "+".join(n for bit, n in VIOLATION_KINDS if kind & bit)
+                yield time_ms, tname, seq, "periodic%d" % slot, kinds, (finish - start) & 0xFFFFFFFF
+        elif ftype == TEL_THREAD and len(payload) == 8:
+            execs, wait = struct.unpack("<II", payload)
+            yield time_ms, tname, fid, name, "exec", execs
+            yield time_ms, tname, fid, name, "wait", wait
+        else:
+            yield time_ms, tname, fid, name, "raw", payload.hex()
+
+
+def main():
+    if len(sys.argv) > 1:
+        with open(sys.argv[1], "rb") as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+    out = sys.stdout
+    out.write("time_ms,type,id,name,field,value\n")
+    for row in rows(data):
+        out.write(",".join(str(v) for v in row) + "\n")
+
+
+if __name__ == "__main__":
+    main()
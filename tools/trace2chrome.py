@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+# trace2chrome.py
+# Convert the kernel trace records in a telemetry capture into Chrome
+# trace JSON.  Open the result in chrome://tracing or ui.perfetto.dev.
+# Start the capture, type "trace" in the shell, then stop the capture.
+#
+# usage: python3 trace2chrome.py capture.bin > trace.json
+
+import json
+import struct
+import sys
+
+import teldecode
+
+TEL_TRACE = 5
+
+TRACE_SWITCH = 1
+TRACE_WAIT = 2
+TRACE_SIGNAL = 3
+TRACE_BLOCK = 4
+TRACE_ISR_ENTER = 5
+TRACE_ISR_EXIT = 6
+TRACE_CREATE = 7
+TRACE_KILL = 8
+
+# TRACE_IRQ_ values in os.h
+IRQ_NAMES = {5: "UART0", 15: "ADC0Seq1", 21: "Timer1A", 23: "Timer2A"}
+SEMA_EVENTS = {TRACE_WAIT: "wait", TRACE_SIGNAL: "signal", TRACE_BLOCK: "block"}
+
+TICK_US = 0.0125  # OS_Time() runs at 80 MHz
+THREAD_PID = 1
+ISR_PID = 2
+
+
+def records(data):
+    """Yield (time, type, thread, arg) in capture order."""
+    for ftype, _, _, payload in teldecode.frames(data):
+        if ftype != TEL_TRACE:
+            continue
+        for i in range(0, len(payload) - 9, 10):
+            yield struct.unpack("<IBBI", payload[i:i + 10])
+
+
+def convert(data):
+    events = []
+    last = None
+    base = 0  # OS_Time() wraps every 53 s
+    running = None
+    start = None
+    for time, etype, thread, arg in records(data):
+        if last is not None and time < last:
+            base += 1 << 32
+        last = time
+        ts = (base + time) * TICK_US
+        if etype == TRACE_SWITCH:
+            if running is not None:
+                events.append({"name": "thread%d" % running, "ph": "X", "pid": THREAD_PID,
+                               "tid": running, "ts": start, "dur": ts - start})
+            running, start = arg, ts
+        elif etype in (TRACE_ISR_ENTER, TRACE_ISR_EXIT):
+            events.append({"name": IRQ_NAMES.get(arg, "irq%d" % arg),
+                           "ph": "B" if etype == TRACE_ISR_ENTER else "E",
+                           "pid": ISR_PID, "tid": arg, "ts": ts})
+        elif etype in SEMA_EVENTS:
+            events.append({"name": "%s 0x%08X" % (SEMA_EVENTS[etype], arg), "ph": "i",
+                           "s": "t", "pid": THREAD_PID, "tid": thread, "ts": ts,
+                           "args": {"sema": "0x%08X" % arg}})
+        elif etype in (TRACE_CREATE, TRACE_KILL):
+            events.append({"name": "%s thread%d" % ("create" if etype == TRACE_CREATE
+                                                     else "kill", arg),
+                           "ph": "i", "s": "p", "pid": THREAD_PID, "tid": thread, "ts": ts})
+    meta = [{"name": "process_name", "ph": "M", "pid": THREAD_PID, "args": {"name": "threads"}},
+            {"name": "process_name", "ph": "M", "pid": ISR_PID, "args": {"name": "interrupts"}}]
+    for irq, name in IRQ_NAMES.items():
+        meta.append({"name": "thread_name", "ph": "M", "pid": ISR_PID, "tid": irq,
+                     "args": {"name": name}})
+    return {"traceEvents": meta + events, "displayTimeUnit": "ns"}
+
+
+def main():
+    if len(sys.argv) > 1:
+        with open(sys.argv[1], "rb") as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+    json.dump(convert(data), sys.stdout)
+    sys.stdout.write("\n")
+
+
+if __name__ == "__main__":
+    main()